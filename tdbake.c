@@ -0,0 +1,81 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Bakes a model and its skins into a cache that the game can map
+   instead of parsing the MD2 file and decoding the images at every
+   launch */
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "tdmodel.h"
+#include "tdmodelcache.h"
+
+int
+main (int argc, char **argv)
+{
+  TDModel *model;
+  GError *error = NULL;
+  int i;
+
+  if (argc < 3)
+    {
+      g_printerr ("usage: %s <cache> <model> [extra skin]...\n", argv[0]);
+      return 1;
+    }
+
+  g_type_init ();
+
+  if ((model = td_model_load (argv[2], &error)) == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+
+  for (i = 3; i < argc; i++)
+    if (!td_model_add_skin (model, argv[i], &error))
+      {
+	g_printerr ("%s\n", error->message);
+	g_error_free (error);
+	td_model_unref (model);
+	return 1;
+      }
+
+  if (!td_model_cache_save (model, argv[1], &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      td_model_unref (model);
+      return 1;
+    }
+
+  g_print ("%s: %i frames, %i vertices, %i skins\n",
+	   argv[1], model->n_frames, model->n_vertices, model->n_skins);
+
+  td_model_unref (model);
+
+  return 0;
+}
@@ -0,0 +1,329 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Times the game's hot paths that don't need a stage and prints the
+   results as JSON so that they can be compared between releases. Each
+   benchmark is repeated with twice as many operations until a run
+   takes long enough to time and then that run is repeated to get
+   BENCH_SAMPLES samples. The median is reported along with the
+   allocations made during that sample. Allocations are counted by
+   wrapping malloc and the aligned allocators where the C library
+   lets us, otherwise they are reported as null. Blocks that g_slice
+   hands out from memory it already has are not seen. If BENCH_HISTORY
+   names a file then every sample is added to it to compare with
+   tdbenchcompare */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "tdsim.h"
+#include "tdnumberatlas.h"
+#include "tdmd2file.h"
+#include "tdbenchhistory.h"
+
+/* Minimum time for each sample */
+#define MIN_SECONDS 0.2
+
+#define DEFAULT_SAMPLES 5
+#define MAX_SAMPLES     100
+
+/* Simulation ticks in a second */
+#define TICKS_PER_SECOND (1000 / TD_SIM_TICK_LENGTH)
+
+#ifdef __GLIBC__
+
+#define BENCH_COUNT_ALLOCS
+
+/* glibc exports its allocator under these names as well so a wrapper
+   can count the calls and pass them on */
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n_members, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void *__libc_memalign (size_t alignment, size_t size);
+
+static guint64 n_allocs;
+
+void *
+malloc (size_t size)
+{
+  n_allocs++;
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n_members, size_t size)
+{
+  n_allocs++;
+  return __libc_calloc (n_members, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  n_allocs++;
+  return __libc_realloc (ptr, size);
+}
+
+void *
+memalign (size_t alignment, size_t size)
+{
+  n_allocs++;
+  return __libc_memalign (alignment, size);
+}
+
+void *
+aligned_alloc (size_t alignment, size_t size)
+{
+  n_allocs++;
+  return __libc_memalign (alignment, size);
+}
+
+int
+posix_memalign (void **memptr, size_t alignment, size_t size)
+{
+  void *mem;
+
+  if (alignment % sizeof (void *) || (alignment & (alignment - 1)))
+    return EINVAL;
+
+  n_allocs++;
+
+  if ((mem = __libc_memalign (alignment, size)) == NULL)
+    return ENOMEM;
+
+  *memptr = mem;
+
+  return 0;
+}
+
+#endif /* __GLIBC__ */
+
+typedef void (* BenchFunc) (gpointer data, guint n_ops);
+
+/* Car steering that changes every second like a player weaving
+   between tractors */
+typedef struct
+{
+  float angle, position;
+  guint tick;
+} CarState;
+
+static void
+bench_car (gpointer data, guint n_ops)
+{
+  CarState *car = data;
+  guint i;
+
+  for (i = 0; i < n_ops; i++, car->tick++)
+    td_sim_step_car (&car->angle, &car->position,
+		     (int) (car->tick / TICKS_PER_SECOND % 3) - 1, 640);
+}
+
+static void
+bench_road (gpointer data, guint n_ops)
+{
+  float *road_progress = data;
+  guint i;
+
+  for (i = 0; i < n_ops; i++)
+    *road_progress = td_sim_step_road (*road_progress);
+}
+
+static void
+bench_atlas_build (gpointer data, guint n_ops)
+{
+  guint i;
+
+  for (i = 0; i < n_ops; i++)
+    td_number_atlas_free (td_number_atlas_build ());
+}
+
+typedef struct
+{
+  TDNumberAtlas *atlas;
+  TDNumberLayout layout;
+  int value;
+} SetValueState;
+
+/* This is what td_number_set_value does apart from queueing the
+   redraw */
+static void
+bench_set_value (gpointer data, guint n_ops)
+{
+  SetValueState *state = data;
+  guint i;
+
+  for (i = 0; i < n_ops; i++)
+    td_number_atlas_layout (state->atlas, state->value++, &state->layout);
+}
+
+static void
+bench_md2_load (gpointer data, guint n_ops)
+{
+  guint i;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      GError *error = NULL;
+      TDMD2File *file = td_md2_file_load (data, &error);
+
+      if (file == NULL)
+	g_error ("%s", error->message);
+
+      td_md2_file_free (file);
+    }
+}
+
+static int
+compare_double (gconstpointer a, gconstpointer b)
+{
+  double da = *(const double *) a, db = *(const double *) b;
+
+  return da < db ? -1 : da > db ? 1 : 0;
+}
+
+/* Times func with n_ops operations and returns the nanoseconds per
+   operation. The allocations per operation are stored in allocs */
+static double
+time_bench (BenchFunc func, gpointer data, guint n_ops,
+	    GTimer *timer, double *allocs)
+{
+  guint64 start_allocs = 0, end_allocs = 0;
+  gdouble elapsed;
+
+#ifdef BENCH_COUNT_ALLOCS
+  start_allocs = n_allocs;
+#endif
+  g_timer_start (timer);
+  func (data, n_ops);
+  elapsed = g_timer_elapsed (timer, NULL);
+#ifdef BENCH_COUNT_ALLOCS
+  end_allocs = n_allocs;
+#endif
+
+  *allocs = (end_allocs - start_allocs) / (double) n_ops;
+
+  return elapsed * 1e9 / n_ops;
+}
+
+static void
+run_bench (const char *name, BenchFunc func, gpointer data,
+	   int n_samples, TDBenchHistory *history, gboolean first)
+{
+  GTimer *timer = g_timer_new ();
+  double ns[MAX_SAMPLES], allocs[MAX_SAMPLES], sorted[MAX_SAMPLES];
+  guint n_ops = 1;
+  int i, median = 0;
+
+  /* Warm up the caches and anything that is set up on first use */
+  func (data, 1);
+
+  /* The first run that is long enough is the first sample */
+  while ((ns[0] = time_bench (func, data, n_ops, timer, allocs))
+	 * n_ops < MIN_SECONDS * 1e9
+	 && n_ops < G_MAXUINT / 2)
+    n_ops *= 2;
+
+  for (i = 1; i < n_samples; i++)
+    ns[i] = time_bench (func, data, n_ops, timer, allocs + i);
+
+  g_timer_destroy (timer);
+
+  memcpy (sorted, ns, n_samples * sizeof (double));
+  qsort (sorted, n_samples, sizeof (double), compare_double);
+
+  /* Find which sample was the median so that the allocations are
+     reported from the same run as the time */
+  while (ns[median] != sorted[n_samples / 2])
+    median++;
+
+  g_print ("%s\n    { \"name\": \"%s\", \"ops\": %u, \"samples\": %i, "
+	   "\"ns_per_op\": %.3f, \"allocs_per_op\": ",
+	   first ? "" : ",", name, n_ops, n_samples, ns[median]);
+
+#ifdef BENCH_COUNT_ALLOCS
+  g_print ("%.3f }", allocs[median]);
+#else
+  g_print ("null }");
+#endif
+
+  if (history)
+    {
+      char *metric = g_strconcat ("bench.", name, ".ns_per_op", NULL);
+
+      td_bench_history_add (history, metric, TD_BENCH_LOWER_IS_BETTER,
+			    ns, n_samples);
+      g_free (metric);
+
+#ifdef BENCH_COUNT_ALLOCS
+      metric = g_strconcat ("bench.", name, ".allocs_per_op", NULL);
+      td_bench_history_add (history, metric, TD_BENCH_LOWER_IS_BETTER,
+			    allocs, n_samples);
+      g_free (metric);
+#endif
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  CarState car = { 0.0f, 320.0f, 0 };
+  float road_progress = 0.0f;
+  SetValueState set_value;
+  TDBenchHistory *history = td_bench_history_open_from_env ();
+  int n_samples = DEFAULT_SAMPLES;
+
+  if (getenv ("BENCH_SAMPLES"))
+    n_samples = CLAMP (atoi (getenv ("BENCH_SAMPLES")), 1, MAX_SAMPLES);
+
+  set_value.atlas = td_number_atlas_build ();
+  set_value.value = 0;
+
+  g_print ("{\n  \"benchmarks\": [");
+
+  run_bench ("car_kinematics", bench_car, &car,
+	     n_samples, history, TRUE);
+  run_bench ("road_update", bench_road, &road_progress,
+	     n_samples, history, FALSE);
+  run_bench ("number_atlas_build", bench_atlas_build, NULL,
+	     n_samples, history, FALSE);
+  run_bench ("number_set_value", bench_set_value, &set_value,
+	     n_samples, history, FALSE);
+  run_bench ("md2_load_tractor", bench_md2_load,
+	     "data/tractor/tractor.md2", n_samples, history, FALSE);
+  run_bench ("md2_load_car", bench_md2_load,
+	     "data/car/car.md2", n_samples, history, FALSE);
+
+  g_print ("\n  ]\n}\n");
+
+  td_number_atlas_free (set_value.atlas);
+
+  if (history)
+    td_bench_history_save_and_free (history);
+
+  return 0;
+}
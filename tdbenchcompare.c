@@ -0,0 +1,103 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Compares two runs in a benchmark history written by the benchmarks
+   when BENCH_HISTORY is set. Without any commits it compares the last
+   two that were recorded on this machine and with one it compares
+   that against the latest. Exits with 1 if anything regressed so it
+   can stop a slow change from going in */
+
+#include <glib.h>
+#include <stdlib.h>
+
+#include "tdbenchhistory.h"
+
+int
+main (int argc, char **argv)
+{
+  TDBenchHistory *history;
+  GError *error = NULL;
+  const char *env_machine;
+  char *machine;
+  const char *base_commit, *new_commit;
+  char **commits;
+  guint n_commits, n_regressions;
+
+  if (argc < 2 || argc > 4)
+    {
+      g_printerr ("usage: %s <history> [<base commit> [<new commit>]]\n",
+		  argv[0]);
+      return 2;
+    }
+
+  if ((history = td_bench_history_load (argv[1], &error)) == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return 2;
+    }
+
+  /* The runs are stored under the cleaned up name */
+  if ((env_machine = getenv ("BENCH_MACHINE")) == NULL)
+    env_machine = g_get_host_name ();
+  machine = td_bench_history_clean_name (env_machine);
+
+  commits = td_bench_history_get_commits (history, machine);
+  n_commits = g_strv_length (commits);
+
+  if (argc > 3)
+    {
+      base_commit = argv[2];
+      new_commit = argv[3];
+    }
+  else if (argc > 2 && n_commits >= 1)
+    {
+      base_commit = argv[2];
+      new_commit = commits[n_commits - 1];
+    }
+  else if (argc == 2 && n_commits >= 2)
+    {
+      base_commit = commits[n_commits - 2];
+      new_commit = commits[n_commits - 1];
+    }
+  else
+    {
+      g_printerr ("%s: not enough runs recorded on %s to compare\n",
+		  argv[1], machine);
+      g_strfreev (commits);
+      g_free (machine);
+      td_bench_history_free (history);
+      return 2;
+    }
+
+  n_regressions = td_bench_history_compare (history, machine,
+					    base_commit, new_commit);
+
+  g_strfreev (commits);
+  g_free (machine);
+  td_bench_history_free (history);
+
+  return n_regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,435 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Keeps the results of every benchmark run in a key file so that a
+   build can be compared with an earlier one. Each run is a group
+   named after the commit and the machine it ran on and each metric
+   is a list of samples. Running a benchmark again on the same commit
+   adds more samples. The [Metrics] group records whether a bigger
+   number is better for each metric.
+
+   The comparison treats the change in the mean as noise unless it is
+   more than three standard errors of the difference apart, and never
+   less than NOISE_FLOOR */
+
+#include <glib.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tdbenchhistory.h"
+
+#define TD_BENCH_HISTORY_METRICS_GROUP "Metrics"
+
+/* Smallest relative change to count as a regression */
+#define NOISE_FLOOR       0.01
+/* Threshold to use when there aren't enough samples to measure the
+   noise */
+#define NOISE_FEW_SAMPLES 0.05
+/* How many standard errors of the difference make a real change */
+#define NOISE_SIGMAS      3.0
+
+struct _TDBenchHistory
+{
+  char *filename;
+  GKeyFile *key_file;
+
+  /* Where new samples go */
+  char *commit, *machine;
+};
+
+typedef struct _TDBenchStats TDBenchStats;
+
+struct _TDBenchStats
+{
+  gsize n_samples;
+  double mean, stddev;
+};
+
+/* Loads the history or starts a new one if the file doesn't exist
+   yet. The file isn't written until td_bench_history_save. The commit
+   and machine aren't worked out until they are needed so that only
+   reading the history doesn't run git */
+TDBenchHistory *
+td_bench_history_load (const char *filename, GError **error)
+{
+  TDBenchHistory *history;
+  GKeyFile *key_file = g_key_file_new ();
+  GError *load_error = NULL;
+
+  if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE,
+				  &load_error))
+    {
+      if (!g_error_matches (load_error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+	{
+	  g_propagate_error (error, load_error);
+	  g_key_file_free (key_file);
+	  return NULL;
+	}
+
+      g_error_free (load_error);
+    }
+
+  history = g_slice_new0 (TDBenchHistory);
+  history->filename = g_strdup (filename);
+  history->key_file = key_file;
+
+  return history;
+}
+
+static char *
+td_bench_history_guess_commit (void)
+{
+  char *output = NULL;
+  int status;
+
+  if (g_spawn_command_line_sync ("git describe --always --dirty",
+				 &output, NULL, &status, NULL)
+      && status == 0 && output && *g_strstrip (output))
+    return output;
+
+  g_free (output);
+
+  return g_strdup ("unknown");
+}
+
+/* Replaces anything that would confuse the key file with a dash. The
+   machine has to be cleaned the same way before looking up its
+   runs */
+char *
+td_bench_history_clean_name (const char *name)
+{
+  return g_strcanon (g_strdup (name),
+		     "abcdefghijklmnopqrstuvwxyz"
+		     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+		     "0123456789.-_+",
+		     '-');
+}
+
+/* Sets the commit and machine that new samples belong to. If either
+   is NULL it is taken from git and the host name */
+void
+td_bench_history_set_run (TDBenchHistory *history,
+			  const char *commit,
+			  const char *machine)
+{
+  char *guess = NULL;
+
+  g_free (history->commit);
+  g_free (history->machine);
+
+  if (commit == NULL)
+    commit = guess = td_bench_history_guess_commit ();
+
+  history->commit = td_bench_history_clean_name (commit);
+  history->machine = td_bench_history_clean_name (machine ? machine
+						  : g_get_host_name ());
+
+  g_free (guess);
+}
+
+/* Takes the commit and machine from git and the host name unless
+   td_bench_history_set_run has already been called */
+static void
+td_bench_history_ensure_run (TDBenchHistory *history)
+{
+  if (history->commit == NULL)
+    td_bench_history_set_run (history, NULL, NULL);
+}
+
+/* Opens the history named by BENCH_HISTORY for a benchmark to add its
+   results to. BENCH_COMMIT and BENCH_MACHINE override the commit and
+   the machine. Returns NULL if BENCH_HISTORY isn't set or the file
+   can't be read */
+TDBenchHistory *
+td_bench_history_open_from_env (void)
+{
+  TDBenchHistory *history;
+  GError *error = NULL;
+  const char *filename = getenv ("BENCH_HISTORY");
+
+  if (filename == NULL || *filename == '\0')
+    return NULL;
+
+  if ((history = td_bench_history_load (filename, &error)) == NULL)
+    {
+      g_warning ("%s", error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  td_bench_history_set_run (history, getenv ("BENCH_COMMIT"),
+			    getenv ("BENCH_MACHINE"));
+
+  return history;
+}
+
+void
+td_bench_history_free (TDBenchHistory *history)
+{
+  g_key_file_free (history->key_file);
+  g_free (history->filename);
+  g_free (history->commit);
+  g_free (history->machine);
+
+  g_slice_free (TDBenchHistory, history);
+}
+
+static char *
+td_bench_history_get_group (const char *commit, const char *machine)
+{
+  return g_strconcat (commit, " ", machine, NULL);
+}
+
+/* Appends samples of a metric to the current run */
+void
+td_bench_history_add (TDBenchHistory *history,
+		      const char *metric,
+		      TDBenchDirection direction,
+		      const double *samples,
+		      int n_samples)
+{
+  GString *value = g_string_new (NULL);
+  char buf[G_ASCII_DTOSTR_BUF_SIZE];
+  char *group, *old;
+  int i;
+
+  td_bench_history_ensure_run (history);
+  group = td_bench_history_get_group (history->commit, history->machine);
+
+  /* Keep the samples that are already there */
+  if ((old = g_key_file_get_value (history->key_file, group, metric, NULL)))
+    {
+      g_string_append (value, old);
+      g_free (old);
+    }
+
+  /* Six significant figures is more than the noise and keeps the
+     file small */
+  for (i = 0; i < n_samples; i++)
+    g_string_append_printf (value, "%s;",
+			    g_ascii_formatd (buf, sizeof (buf), "%.6g",
+					     samples[i]));
+
+  g_key_file_set_value (history->key_file, group, metric, value->str);
+  g_key_file_set_value (history->key_file, TD_BENCH_HISTORY_METRICS_GROUP,
+			metric,
+			direction == TD_BENCH_HIGHER_IS_BETTER
+			? "higher" : "lower");
+
+  g_string_free (value, TRUE);
+  g_free (group);
+}
+
+gboolean
+td_bench_history_save (TDBenchHistory *history, GError **error)
+{
+  char *data;
+  gsize length;
+  gboolean ret;
+
+  data = g_key_file_to_data (history->key_file, &length, NULL);
+  ret = g_file_set_contents (history->filename, data, length, error);
+  g_free (data);
+
+  return ret;
+}
+
+/* Saves the history and frees it. Benchmarks shouldn't fail because
+   the history couldn't be written so this only warns */
+void
+td_bench_history_save_and_free (TDBenchHistory *history)
+{
+  GError *error = NULL;
+
+  if (!td_bench_history_save (history, &error))
+    {
+      g_warning ("%s", error->message);
+      g_error_free (error);
+    }
+
+  td_bench_history_free (history);
+}
+
+const char *
+td_bench_history_get_commit (TDBenchHistory *history)
+{
+  td_bench_history_ensure_run (history);
+
+  return history->commit;
+}
+
+const char *
+td_bench_history_get_machine (TDBenchHistory *history)
+{
+  td_bench_history_ensure_run (history);
+
+  return history->machine;
+}
+
+/* Gets the commits that have results for machine in the order they
+   were first recorded */
+char **
+td_bench_history_get_commits (TDBenchHistory *history, const char *machine)
+{
+  char **groups = g_key_file_get_groups (history->key_file, NULL);
+  GPtrArray *commits = g_ptr_array_new ();
+  int i;
+
+  for (i = 0; groups[i]; i++)
+    {
+      char *space = strrchr (groups[i], ' ');
+
+      if (space && !strcmp (space + 1, machine))
+	g_ptr_array_add (commits, g_strndup (groups[i], space - groups[i]));
+    }
+
+  g_ptr_array_add (commits, NULL);
+  g_strfreev (groups);
+
+  return (char **) g_ptr_array_free (commits, FALSE);
+}
+
+static gboolean
+td_bench_history_get_stats (TDBenchHistory *history,
+			    const char *group,
+			    const char *metric,
+			    TDBenchStats *stats)
+{
+  double *samples, sum = 0.0, sum_sq = 0.0;
+  gsize i;
+
+  samples = g_key_file_get_double_list (history->key_file, group, metric,
+					&stats->n_samples, NULL);
+
+  if (samples == NULL || stats->n_samples == 0)
+    {
+      g_free (samples);
+      return FALSE;
+    }
+
+  for (i = 0; i < stats->n_samples; i++)
+    sum += samples[i];
+  stats->mean = sum / stats->n_samples;
+
+  for (i = 0; i < stats->n_samples; i++)
+    sum_sq += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+  stats->stddev = (stats->n_samples > 1
+		   ? sqrt (sum_sq / (stats->n_samples - 1)) : 0.0);
+
+  g_free (samples);
+
+  return TRUE;
+}
+
+/* Prints every metric that both commits have on machine and flags the
+   ones that got worse by more than the noise. Returns the number of
+   regressions */
+guint
+td_bench_history_compare (TDBenchHistory *history,
+			  const char *machine,
+			  const char *base_commit,
+			  const char *new_commit)
+{
+  char *base_group = td_bench_history_get_group (base_commit, machine);
+  char *new_group = td_bench_history_get_group (new_commit, machine);
+  char **metrics;
+  guint n_regressions = 0;
+  gboolean any_few_samples = FALSE;
+  int i;
+
+  g_print ("%s -> %s on %s\n"
+	   "%-40s %12s %12s %8s %7s\n",
+	   base_commit, new_commit, machine,
+	   "metric", "base", "new", "change", "noise");
+
+  metrics = g_key_file_get_keys (history->key_file, new_group, NULL, NULL);
+
+  for (i = 0; metrics && metrics[i]; i++)
+    {
+      TDBenchStats base, new;
+      double change, noise, scale;
+      char *direction;
+      gboolean few_samples;
+      const char *verdict = "";
+
+      if (!td_bench_history_get_stats (history, base_group, metrics[i], &base)
+	  || !td_bench_history_get_stats (history, new_group, metrics[i],
+					  &new))
+	continue;
+
+      /* Relative to the base unless it is zero such as for a
+	 benchmark that didn't allocate */
+      scale = fabs (base.mean) > 0.0 ? fabs (base.mean) : 1.0;
+      change = (new.mean - base.mean) / scale;
+
+      few_samples = base.n_samples < 2 || new.n_samples < 2;
+      if (few_samples)
+	{
+	  noise = NOISE_FEW_SAMPLES;
+	  any_few_samples = TRUE;
+	}
+      else
+	noise = MAX (NOISE_SIGMAS
+		     * sqrt (base.stddev * base.stddev / base.n_samples
+			     + new.stddev * new.stddev / new.n_samples)
+		     / scale,
+		     NOISE_FLOOR);
+
+      direction = g_key_file_get_value (history->key_file,
+					TD_BENCH_HISTORY_METRICS_GROUP,
+					metrics[i], NULL);
+
+      /* Make a positive change mean worse */
+      if (direction && !strcmp (direction, "higher"))
+	change = -change;
+
+      if (change > noise)
+	{
+	  verdict = "  REGRESSED";
+	  n_regressions++;
+	}
+      else if (change < -noise)
+	verdict = "  improved";
+
+      g_print ("%-40s %12.4g %12.4g %+7.1f%% %6.1f%%%s%s\n",
+	       metrics[i], base.mean, new.mean,
+	       (new.mean - base.mean) * 100.0 / scale, noise * 100.0,
+	       few_samples ? "*" : "", verdict);
+
+      g_free (direction);
+    }
+
+  g_print ("%u regression%s%s\n", n_regressions,
+	   n_regressions == 1 ? "" : "s",
+	   any_few_samples
+	   ? " (* means too few samples to measure the noise)" : "");
+
+  g_strfreev (metrics);
+  g_free (base_group);
+  g_free (new_group);
+
+  return n_regressions;
+}
@@ -0,0 +1,70 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_BENCH_HISTORY_H
+#define _HAVE_TD_BENCH_HISTORY_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _TDBenchHistory TDBenchHistory;
+
+typedef enum
+{
+  TD_BENCH_LOWER_IS_BETTER,
+  TD_BENCH_HIGHER_IS_BETTER
+} TDBenchDirection;
+
+TDBenchHistory *td_bench_history_load (const char *filename, GError **error);
+TDBenchHistory *td_bench_history_open_from_env (void);
+void td_bench_history_free (TDBenchHistory *history);
+
+void td_bench_history_set_run (TDBenchHistory *history,
+			       const char *commit,
+			       const char *machine);
+void td_bench_history_add (TDBenchHistory *history,
+			   const char *metric,
+			   TDBenchDirection direction,
+			   const double *samples,
+			   int n_samples);
+gboolean td_bench_history_save (TDBenchHistory *history, GError **error);
+void td_bench_history_save_and_free (TDBenchHistory *history);
+
+const char *td_bench_history_get_commit (TDBenchHistory *history);
+const char *td_bench_history_get_machine (TDBenchHistory *history);
+
+char **td_bench_history_get_commits (TDBenchHistory *history,
+				     const char *machine);
+guint td_bench_history_compare (TDBenchHistory *history,
+				const char *machine,
+				const char *base_commit,
+				const char *new_commit);
+
+char *td_bench_history_clean_name (const char *name);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_BENCH_HISTORY_H */
@@ -27,6 +27,7 @@
 #include <clutter/clutter-container.h>
 
 #include "tdcornerlayout.h"
+#include "tdprofiler.h"
 
 static void clutter_container_iface_init (ClutterContainerIface *iface);
 
@@ -117,6 +118,9 @@ td_corner_layout_allocate (ClutterActor          *self,
 			   gboolean               origin_changed)
 {
   TDCornerLayoutPrivate *priv;
+  TDProfilerScope scope;
+
+  td_profiler_begin (&scope, TD_PROFILER_PHASE_LAYOUT);
 
   /* chain up to set actor->allocation */
   CLUTTER_ACTOR_CLASS (td_corner_layout_parent_class)
@@ -141,6 +145,8 @@ td_corner_layout_allocate (ClutterActor          *self,
 
       clutter_actor_allocate (priv->child, &child_box, origin_changed);
     }
+
+  td_profiler_end (&scope);
 }
 
 static void
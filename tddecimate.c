@@ -0,0 +1,100 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Builds simpler versions of an MD2 model for drawing it in the
+   distance. Each level is given as a percentage of the original
+   triangles followed by the file to write it to. The skins aren't
+   stored in the levels because they are drawn with the textures of
+   the full model */
+
+#include <glib.h>
+#include <stdlib.h>
+
+#include "tdmd2file.h"
+#include "tdmd2decimate.h"
+
+static void
+report_level (int level, const TDMD2File *file, const char *filename)
+{
+  g_print ("  level %i: %5i triangles, %4i vertices  %s\n",
+	   level, file->n_triangles, file->n_vertices, filename);
+}
+
+int
+main (int argc, char **argv)
+{
+  TDMD2File *file;
+  GError *error = NULL;
+  int i;
+
+  if (argc < 4 || argc % 2 != 0)
+    {
+      g_printerr ("usage: %s <model> <percent> <output> "
+		  "[<percent> <output>]...\n", argv[0]);
+      return 1;
+    }
+
+  if ((file = td_md2_file_load (argv[1], &error)) == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return 1;
+    }
+
+  g_print ("%s: %i frames\n", argv[1], file->n_frames);
+  report_level (0, file, argv[1]);
+
+  for (i = 2; i < argc; i += 2)
+    {
+      int percent = atoi (argv[i]);
+      TDMD2File *level;
+      gboolean ret;
+
+      level = td_md2_decimate (file, file->n_triangles * percent / 100);
+
+      g_strfreev (level->skins);
+      level->skins = g_new0 (char *, 1);
+      level->n_skins = 0;
+
+      ret = td_md2_file_save (level, argv[i + 1], &error);
+
+      if (ret)
+	report_level (i / 2, level, argv[i + 1]);
+
+      td_md2_file_free (level);
+
+      if (!ret)
+	{
+	  g_printerr ("%s\n", error->message);
+	  g_error_free (error);
+	  td_md2_file_free (file);
+	  return 1;
+	}
+    }
+
+  td_md2_file_free (file);
+
+  return 0;
+}
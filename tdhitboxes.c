@@ -0,0 +1,149 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <math.h>
+
+#include "tdhitboxes.h"
+
+TDHitBoxes *
+td_hit_boxes_new (const TDMD2File *file)
+{
+  TDHitBoxes *boxes = g_slice_new (TDHitBoxes);
+  float min_x = G_MAXFLOAT, max_x = -G_MAXFLOAT;
+  float min_y = G_MAXFLOAT, max_y = -G_MAXFLOAT;
+  float center_x, center_y, scale;
+  int frame, i;
+
+  boxes->n_frames = file->n_frames;
+  boxes->frames = g_new (TDHitBox, file->n_frames);
+
+  for (frame = 0; frame < file->n_frames; frame++)
+    {
+      const float *v = file->frames[frame].vertices;
+      TDHitBox *box = boxes->frames + frame;
+
+      box->x1 = box->y1 = G_MAXFLOAT;
+      box->x2 = box->y2 = -G_MAXFLOAT;
+
+      for (i = 0; i < file->n_vertices; i++, v += 3)
+	{
+	  box->x1 = MIN (box->x1, v[0]);
+	  box->x2 = MAX (box->x2, v[0]);
+	  box->y1 = MIN (box->y1, v[1]);
+	  box->y2 = MAX (box->y2, v[1]);
+	}
+
+      min_x = MIN (min_x, box->x1);
+      max_x = MAX (max_x, box->x2);
+      min_y = MIN (min_y, box->y1);
+      max_y = MAX (max_y, box->y2);
+    }
+
+  /* ClutterMD2 fits the extents of the whole animation into the
+     actor, keeping the aspect ratio and centering it. The model's Z
+     axis points out of the screen and its Y axis points up so we can
+     convert each box to fractions of the actor */
+  center_x = (min_x + max_x) / 2.0f;
+  center_y = (min_y + max_y) / 2.0f;
+  scale = MAX (max_x - min_x, max_y - min_y);
+  if (scale <= 0.0f)
+    scale = 1.0f;
+
+  for (frame = 0; frame < file->n_frames; frame++)
+    {
+      TDHitBox *box = boxes->frames + frame;
+      TDHitBox model_box = *box;
+
+      box->x1 = (model_box.x1 - center_x) / scale + 0.5f;
+      box->x2 = (model_box.x2 - center_x) / scale + 0.5f;
+      box->y1 = 0.5f - (model_box.y2 - center_y) / scale;
+      box->y2 = 0.5f - (model_box.y1 - center_y) / scale;
+    }
+
+  return boxes;
+}
+
+TDHitBoxes *
+td_hit_boxes_new_from_boxes (int n_frames, const TDHitBox *frames)
+{
+  TDHitBoxes *boxes = g_slice_new (TDHitBoxes);
+
+  boxes->n_frames = n_frames;
+  boxes->frames = g_memdup (frames, n_frames * sizeof (TDHitBox));
+
+  return boxes;
+}
+
+void
+td_hit_boxes_free (TDHitBoxes *boxes)
+{
+  g_free (boxes->frames);
+  g_slice_free (TDHitBoxes, boxes);
+}
+
+/* Gets the box for a frame of the model when the actor is rotated
+   around the Z axis by angle degrees about its center. For rotations
+   other than multiples of 180 degrees this is the box around the
+   rotated box */
+void
+td_hit_boxes_get_box (const TDHitBoxes *boxes,
+		      int frame,
+		      float angle,
+		      TDHitBox *box)
+{
+  const TDHitBox *src
+    = boxes->frames + CLAMP (frame, 0, boxes->n_frames - 1);
+
+  if (angle == 0.0f)
+    *box = *src;
+  else if (angle == 180.0f)
+    {
+      box->x1 = 1.0f - src->x2;
+      box->x2 = 1.0f - src->x1;
+      box->y1 = 1.0f - src->y2;
+      box->y2 = 1.0f - src->y1;
+    }
+  else
+    {
+      float radians = angle * G_PI / 180.0f;
+      float c = cosf (radians), s = sinf (radians);
+      /* Half of the size of the rotated box */
+      float half_width = (fabsf (c) * (src->x2 - src->x1)
+			  + fabsf (s) * (src->y2 - src->y1)) / 2.0f;
+      float half_height = (fabsf (s) * (src->x2 - src->x1)
+			   + fabsf (c) * (src->y2 - src->y1)) / 2.0f;
+      /* Rotate the center of the box around the center of the actor */
+      float cx = (src->x1 + src->x2) / 2.0f - 0.5f;
+      float cy = (src->y1 + src->y2) / 2.0f - 0.5f;
+      float rx = cx * c - cy * s + 0.5f;
+      float ry = cx * s + cy * c + 0.5f;
+
+      box->x1 = rx - half_width;
+      box->x2 = rx + half_width;
+      box->y1 = ry - half_height;
+      box->y2 = ry + half_height;
+    }
+}
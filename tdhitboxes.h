@@ -0,0 +1,65 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_HIT_BOXES_H
+#define _HAVE_TD_HIT_BOXES_H
+
+#include <glib.h>
+
+#include "tdmd2file.h"
+
+G_BEGIN_DECLS
+
+typedef struct _TDHitBox   TDHitBox;
+typedef struct _TDHitBoxes TDHitBoxes;
+
+/* A box around a model in fractions of the size of the actor
+   displaying it so that (0,0) is the top left of the actor and (1,1)
+   is the bottom right */
+struct _TDHitBox
+{
+  float x1, y1, x2, y2;
+};
+
+/* Tight boxes around each keyframe of a model */
+struct _TDHitBoxes
+{
+  int n_frames;
+  TDHitBox *frames;
+};
+
+TDHitBoxes *td_hit_boxes_new (const TDMD2File *file);
+TDHitBoxes *td_hit_boxes_new_from_boxes (int n_frames,
+					 const TDHitBox *frames);
+void td_hit_boxes_free (TDHitBoxes *boxes);
+
+void td_hit_boxes_get_box (const TDHitBoxes *boxes,
+			   int frame,
+			   float angle,
+			   TDHitBox *box);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_HIT_BOXES_H */
@@ -0,0 +1,296 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Records the player's steering so that a game can be played back
+   exactly. Together with the seed of the game this is all that is
+   needed because the simulation only moves in whole ticks.
+
+   The file is a header of three little endian 32-bit numbers (the
+   magic, the version and the seed) followed by one record per event.
+   Each record is the number of ticks since the previous event as an
+   unsigned LEB128 number followed by one byte holding the steering
+   direction plus one */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "tdinputlog.h"
+
+#define TD_INPUT_LOG_MAGIC   0x4c494454 /* "TDIL" */
+#define TD_INPUT_LOG_VERSION 1
+
+#define TD_INPUT_LOG_HEADER_SIZE 12
+
+typedef struct _TDInputLogEvent TDInputLogEvent;
+
+struct _TDInputLogEvent
+{
+  guint tick;
+  int direction;
+};
+
+struct _TDInputLog
+{
+  guint32 seed;
+
+  /* Set while recording */
+  FILE *file;
+  char *filename;
+  gboolean write_failed;
+
+  GArray *events;
+  /* Next event to play back */
+  guint position;
+  guint last_tick;
+};
+
+GQuark
+td_input_log_error_quark (void)
+{
+  return g_quark_from_static_string ("td-input-log-error-quark");
+}
+
+static void
+td_input_log_write (TDInputLog *log, const guint8 *data, gsize size)
+{
+  if (!log->write_failed && fwrite (data, 1, size, log->file) != size)
+    {
+      g_warning ("%s: %s", log->filename, g_strerror (errno));
+      log->write_failed = TRUE;
+    }
+}
+
+static void
+td_input_log_write_uint32 (TDInputLog *log, guint32 v)
+{
+  v = GUINT32_TO_LE (v);
+  td_input_log_write (log, (const guint8 *) &v, sizeof (v));
+}
+
+/* Starts recording to filename for a game started with seed */
+TDInputLog *
+td_input_log_new (const char *filename, guint32 seed, GError **error)
+{
+  TDInputLog *log;
+  FILE *file;
+
+  if ((file = g_fopen (filename, "wb")) == NULL)
+    {
+      int errnum = errno;
+
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errnum),
+		   "%s: %s", filename, g_strerror (errnum));
+
+      return NULL;
+    }
+
+  log = g_slice_new0 (TDInputLog);
+  log->seed = seed;
+  log->file = file;
+  log->filename = g_strdup (filename);
+  log->events = g_array_new (FALSE, FALSE, sizeof (TDInputLogEvent));
+
+  td_input_log_write_uint32 (log, TD_INPUT_LOG_MAGIC);
+  td_input_log_write_uint32 (log, TD_INPUT_LOG_VERSION);
+  td_input_log_write_uint32 (log, seed);
+
+  return log;
+}
+
+/* Records that the steering changed to direction just before the
+   given tick ran */
+void
+td_input_log_add_steer (TDInputLog *log, guint tick, int direction)
+{
+  TDInputLogEvent event;
+  guint8 record[6];
+  guint delta;
+  int length = 0;
+
+  g_return_if_fail (log->file != NULL);
+  g_return_if_fail (tick >= log->last_tick);
+
+  event.tick = tick;
+  event.direction = CLAMP (direction, -1, 1);
+  g_array_append_val (log->events, event);
+
+  delta = tick - log->last_tick;
+  log->last_tick = tick;
+
+  do
+    {
+      record[length] = delta & 0x7f;
+      delta >>= 7;
+      if (delta)
+	record[length] |= 0x80;
+      length++;
+    }
+  while (delta);
+
+  record[length++] = event.direction + 1;
+
+  td_input_log_write (log, record, length);
+}
+
+/* Reads a whole log to be played back */
+TDInputLog *
+td_input_log_load (const char *filename, GError **error)
+{
+  TDInputLog *log;
+  gchar *contents;
+  gsize length, pos;
+  const guint8 *data;
+  guint32 header[3];
+  guint tick = 0;
+  int i;
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  data = (const guint8 *) contents;
+
+  if (length < TD_INPUT_LOG_HEADER_SIZE)
+    goto invalid;
+
+  for (i = 0; i < 3; i++)
+    {
+      memcpy (header + i, data + i * 4, 4);
+      header[i] = GUINT32_FROM_LE (header[i]);
+    }
+
+  if (header[0] != TD_INPUT_LOG_MAGIC || header[1] != TD_INPUT_LOG_VERSION)
+    goto invalid;
+
+  log = g_slice_new0 (TDInputLog);
+  log->seed = header[2];
+  log->events = g_array_new (FALSE, FALSE, sizeof (TDInputLogEvent));
+
+  for (pos = TD_INPUT_LOG_HEADER_SIZE; pos < length;)
+    {
+      TDInputLogEvent event;
+      guint delta = 0;
+      int shift = 0;
+
+      do
+	{
+	  if (pos >= length || shift > 28)
+	    {
+	      td_input_log_free (log);
+	      goto invalid;
+	    }
+	  delta |= (data[pos] & 0x7f) << shift;
+	  shift += 7;
+	}
+      while (data[pos++] & 0x80);
+
+      if (pos >= length || data[pos] > 2)
+	{
+	  td_input_log_free (log);
+	  goto invalid;
+	}
+
+      tick += delta;
+      event.tick = tick;
+      event.direction = data[pos++] - 1;
+      g_array_append_val (log->events, event);
+    }
+
+  g_free (contents);
+
+  return log;
+
+ invalid:
+  g_set_error (error, TD_INPUT_LOG_ERROR, TD_INPUT_LOG_ERROR_INVALID,
+	       "%s is not a valid input log", filename);
+  g_free (contents);
+
+  return NULL;
+}
+
+/* Finds the steering recorded for tick. Ticks must be asked for in
+   order. Returns FALSE if the steering didn't change */
+gboolean
+td_input_log_get_steer (TDInputLog *log, guint tick, int *direction)
+{
+  gboolean changed = FALSE;
+
+  while (log->position < log->events->len)
+    {
+      const TDInputLogEvent *event
+	= &g_array_index (log->events, TDInputLogEvent, log->position);
+
+      if (event->tick > tick)
+	break;
+
+      *direction = event->direction;
+      changed = TRUE;
+      log->position++;
+    }
+
+  return changed;
+}
+
+gboolean
+td_input_log_is_finished (TDInputLog *log)
+{
+  return log->position >= log->events->len;
+}
+
+/* Goes back to the first event to play the log again */
+void
+td_input_log_rewind (TDInputLog *log)
+{
+  log->position = 0;
+}
+
+guint32
+td_input_log_get_seed (TDInputLog *log)
+{
+  return log->seed;
+}
+
+guint
+td_input_log_get_n_events (TDInputLog *log)
+{
+  return log->events->len;
+}
+
+void
+td_input_log_free (TDInputLog *log)
+{
+  if (log->file)
+    {
+      if (fclose (log->file) != 0 && !log->write_failed)
+	g_warning ("%s: %s", log->filename, g_strerror (errno));
+      g_free (log->filename);
+    }
+
+  g_array_free (log->events, TRUE);
+
+  g_slice_free (TDInputLog, log);
+}
@@ -0,0 +1,63 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_INPUT_LOG_H
+#define _HAVE_TD_INPUT_LOG_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define TD_INPUT_LOG_ERROR (td_input_log_error_quark ())
+
+typedef enum
+{
+  TD_INPUT_LOG_ERROR_INVALID
+} TDInputLogError;
+
+typedef struct _TDInputLog TDInputLog;
+
+GQuark td_input_log_error_quark (void);
+
+TDInputLog *td_input_log_new (const char *filename,
+			      guint32 seed,
+			      GError **error);
+void td_input_log_add_steer (TDInputLog *log, guint tick, int direction);
+
+TDInputLog *td_input_log_load (const char *filename, GError **error);
+gboolean td_input_log_get_steer (TDInputLog *log,
+				 guint tick,
+				 int *direction);
+gboolean td_input_log_is_finished (TDInputLog *log);
+void td_input_log_rewind (TDInputLog *log);
+
+guint32 td_input_log_get_seed (TDInputLog *log);
+guint td_input_log_get_n_events (TDInputLog *log);
+
+void td_input_log_free (TDInputLog *log);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_INPUT_LOG_H */
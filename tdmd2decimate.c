@@ -0,0 +1,366 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Makes a simpler version of an MD2 model by repeatedly collapsing
+   the shortest edge. Each collapse moves one vertex onto a neighbour
+   that it shares an edge with instead of making up a new position,
+   so the vertex still has a real position in every keyframe and the
+   animation keeps working. The length of an edge is taken as its
+   longest length over all of the keyframes */
+
+#include <glib.h>
+#include <string.h>
+
+#include "tdmd2decimate.h"
+
+typedef struct _TDMD2Collapse TDMD2Collapse;
+
+/* Moving vertex from onto vertex to */
+struct _TDMD2Collapse
+{
+  guint16 from, to;
+  float cost;
+};
+
+typedef struct
+{
+  const TDMD2File *file;
+
+  /* Working copy of the triangles and whether each one is still
+     there */
+  TDMD2Triangle *triangles;
+  gboolean *alive;
+  int n_alive;
+
+  GArray *collapses;
+} TDMD2Decimate;
+
+static float
+td_md2_decimate_get_cost (const TDMD2File *file, int a, int b)
+{
+  float cost = 0.0f;
+  int frame, k;
+
+  for (frame = 0; frame < file->n_frames; frame++)
+    {
+      const float *v = file->frames[frame].vertices;
+      float length = 0.0f;
+
+      for (k = 0; k < 3; k++)
+	{
+	  float d = v[a * 3 + k] - v[b * 3 + k];
+	  length += d * d;
+	}
+
+      cost = MAX (cost, length);
+    }
+
+  return cost;
+}
+
+static int
+td_md2_decimate_compare (gconstpointer a, gconstpointer b)
+{
+  const TDMD2Collapse *ca = a, *cb = b;
+
+  return ca->cost < cb->cost ? -1 : ca->cost > cb->cost ? 1 : 0;
+}
+
+/* Lists both directions of every edge of the remaining triangles from
+   the cheapest to the most expensive */
+static void
+td_md2_decimate_find_collapses (TDMD2Decimate *data)
+{
+  int i, j;
+
+  g_array_set_size (data->collapses, 0);
+
+  for (i = 0; i < data->file->n_triangles; i++)
+    if (data->alive[i])
+      for (j = 0; j < 3; j++)
+	{
+	  TDMD2Collapse collapse;
+
+	  collapse.from = data->triangles[i].vertices[j];
+	  collapse.to = data->triangles[i].vertices[(j + 1) % 3];
+	  collapse.cost = td_md2_decimate_get_cost (data->file,
+						    collapse.from,
+						    collapse.to);
+	  g_array_append_val (data->collapses, collapse);
+
+	  collapse.from = data->triangles[i].vertices[(j + 1) % 3];
+	  collapse.to = data->triangles[i].vertices[j];
+	  g_array_append_val (data->collapses, collapse);
+	}
+
+  g_array_sort (data->collapses, td_md2_decimate_compare);
+}
+
+static void
+td_md2_decimate_get_normal (const float *v,
+			    const guint16 *indices,
+			    float *normal)
+{
+  const float *a = v + indices[0] * 3;
+  const float *b = v + indices[1] * 3;
+  const float *c = v + indices[2] * 3;
+  float u[3], w[3];
+  int k;
+
+  for (k = 0; k < 3; k++)
+    {
+      u[k] = b[k] - a[k];
+      w[k] = c[k] - a[k];
+    }
+
+  normal[0] = u[1] * w[2] - u[2] * w[1];
+  normal[1] = u[2] * w[0] - u[0] * w[2];
+  normal[2] = u[0] * w[1] - u[1] * w[0];
+}
+
+/* A collapse can't be used if it would turn any of the triangles
+   around the vertex inside out in any keyframe */
+static gboolean
+td_md2_decimate_is_valid (TDMD2Decimate *data,
+			  const TDMD2Collapse *collapse)
+{
+  const TDMD2File *file = data->file;
+  int i, j, frame;
+
+  if (collapse->from == collapse->to)
+    return FALSE;
+
+  for (i = 0; i < file->n_triangles; i++)
+    {
+      const TDMD2Triangle *triangle = data->triangles + i;
+      guint16 moved[3];
+      gboolean has_from = FALSE;
+
+      if (!data->alive[i])
+	continue;
+
+      for (j = 0; j < 3; j++)
+	{
+	  if (triangle->vertices[j] == collapse->to)
+	    break;
+	  if (triangle->vertices[j] == collapse->from)
+	    has_from = TRUE;
+	  moved[j] = (triangle->vertices[j] == collapse->from
+		      ? collapse->to : triangle->vertices[j]);
+	}
+
+      /* Triangles on the edge disappear and others aren't touched */
+      if (j < 3 || !has_from)
+	continue;
+
+      for (frame = 0; frame < file->n_frames; frame++)
+	{
+	  const float *v = file->frames[frame].vertices;
+	  float before[3], after[3];
+
+	  td_md2_decimate_get_normal (v, triangle->vertices, before);
+	  td_md2_decimate_get_normal (v, moved, after);
+
+	  if (before[0] * after[0] + before[1] * after[1]
+	      + before[2] * after[2] <= 0.0f)
+	    return FALSE;
+	}
+    }
+
+  return TRUE;
+}
+
+static void
+td_md2_decimate_apply (TDMD2Decimate *data,
+		       const TDMD2Collapse *collapse)
+{
+  const TDMD2File *file = data->file;
+  /* Texture coordinates used by the removed vertex in the triangles
+     that disappear and the ones used by the vertex it moves onto, so
+     that the rest of the triangles can follow across the same seam */
+  GHashTable *st_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+  int i, j;
+
+  for (i = 0; i < file->n_triangles; i++)
+    {
+      TDMD2Triangle *triangle = data->triangles + i;
+      int from = -1, to = -1;
+
+      if (!data->alive[i])
+	continue;
+
+      for (j = 0; j < 3; j++)
+	if (triangle->vertices[j] == collapse->from)
+	  from = j;
+	else if (triangle->vertices[j] == collapse->to)
+	  to = j;
+
+      if (from != -1 && to != -1)
+	{
+	  g_hash_table_insert (st_map,
+			       GINT_TO_POINTER (triangle->st[from]),
+			       GINT_TO_POINTER (triangle->st[to] + 1));
+	  data->alive[i] = FALSE;
+	  data->n_alive--;
+	}
+    }
+
+  for (i = 0; i < file->n_triangles; i++)
+    {
+      TDMD2Triangle *triangle = data->triangles + i;
+
+      if (!data->alive[i])
+	continue;
+
+      for (j = 0; j < 3; j++)
+	if (triangle->vertices[j] == collapse->from)
+	  {
+	    int st = GPOINTER_TO_INT (g_hash_table_lookup
+				      (st_map,
+				       GINT_TO_POINTER (triangle->st[j])));
+
+	    triangle->vertices[j] = collapse->to;
+	    if (st)
+	      triangle->st[j] = st - 1;
+	  }
+    }
+
+  g_hash_table_destroy (st_map);
+}
+
+/* Builds a new file from the remaining triangles with only the
+   vertices and texture coordinates that they still use */
+static TDMD2File *
+td_md2_decimate_build (TDMD2Decimate *data)
+{
+  const TDMD2File *file = data->file;
+  TDMD2File *out = g_slice_new0 (TDMD2File);
+  int *vertex_map = g_new (int, file->n_vertices);
+  int *st_map = g_new (int, file->n_st);
+  int i, j, frame;
+
+  memset (vertex_map, 0xff, sizeof (int) * file->n_vertices);
+  memset (st_map, 0xff, sizeof (int) * file->n_st);
+
+  out->skin_width = file->skin_width;
+  out->skin_height = file->skin_height;
+  out->n_skins = file->n_skins;
+  out->skins = g_strdupv (file->skins);
+
+  out->triangles = g_new (TDMD2Triangle, data->n_alive);
+  for (i = 0; i < file->n_triangles; i++)
+    if (data->alive[i])
+      {
+	TDMD2Triangle *triangle = out->triangles + out->n_triangles++;
+
+	for (j = 0; j < 3; j++)
+	  {
+	    int v = data->triangles[i].vertices[j];
+	    int st = data->triangles[i].st[j];
+
+	    if (vertex_map[v] == -1)
+	      vertex_map[v] = out->n_vertices++;
+	    if (st_map[st] == -1)
+	      st_map[st] = out->n_st++;
+
+	    triangle->vertices[j] = vertex_map[v];
+	    triangle->st[j] = st_map[st];
+	  }
+      }
+
+  out->st = g_new (gint16, out->n_st * 2);
+  for (i = 0; i < file->n_st; i++)
+    if (st_map[i] != -1)
+      memcpy (out->st + st_map[i] * 2, file->st + i * 2, sizeof (gint16) * 2);
+
+  out->n_frames = file->n_frames;
+  out->frames = g_new (TDMD2Frame, out->n_frames);
+  for (frame = 0; frame < file->n_frames; frame++)
+    {
+      memcpy (out->frames[frame].name, file->frames[frame].name,
+	      sizeof (out->frames[frame].name));
+      out->frames[frame].vertices = g_new (float, out->n_vertices * 3);
+
+      for (i = 0; i < file->n_vertices; i++)
+	if (vertex_map[i] != -1)
+	  memcpy (out->frames[frame].vertices + vertex_map[i] * 3,
+		  file->frames[frame].vertices + i * 3,
+		  sizeof (float) * 3);
+    }
+
+  g_free (vertex_map);
+  g_free (st_map);
+
+  return out;
+}
+
+/* Returns a copy of file with at most n_triangles triangles, or as
+   few as could be collapsed without turning any inside out */
+TDMD2File *
+td_md2_decimate (const TDMD2File *file, int n_triangles)
+{
+  TDMD2Decimate data;
+  TDMD2File *out;
+  guint i;
+
+  data.file = file;
+  data.triangles = g_memdup (file->triangles,
+			     sizeof (TDMD2Triangle) * file->n_triangles);
+  data.alive = g_new (gboolean, file->n_triangles);
+  data.n_alive = file->n_triangles;
+  data.collapses = g_array_new (FALSE, FALSE, sizeof (TDMD2Collapse));
+
+  for (i = 0; i < file->n_triangles; i++)
+    data.alive[i] = TRUE;
+
+  while (data.n_alive > n_triangles)
+    {
+      td_md2_decimate_find_collapses (&data);
+
+      for (i = 0; i < data.collapses->len; i++)
+	{
+	  TDMD2Collapse *collapse
+	    = &g_array_index (data.collapses, TDMD2Collapse, i);
+
+	  if (td_md2_decimate_is_valid (&data, collapse))
+	    {
+	      td_md2_decimate_apply (&data, collapse);
+	      break;
+	    }
+	}
+
+      /* Nothing left that can be collapsed */
+      if (i >= data.collapses->len)
+	break;
+    }
+
+  out = td_md2_decimate_build (&data);
+
+  g_array_free (data.collapses, TRUE);
+  g_free (data.alive);
+  g_free (data.triangles);
+
+  return out;
+}
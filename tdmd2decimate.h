@@ -0,0 +1,39 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_MD2_DECIMATE_H
+#define _HAVE_TD_MD2_DECIMATE_H
+
+#include <glib.h>
+
+#include "tdmd2file.h"
+
+G_BEGIN_DECLS
+
+TDMD2File *td_md2_decimate (const TDMD2File *file, int n_triangles);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_MD2_DECIMATE_H */
@@ -0,0 +1,368 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "tdmd2file.h"
+
+#define TD_MD2_FILE_MAGIC   0x32504449 /* "IDP2" */
+#define TD_MD2_FILE_VERSION 8
+
+#define TD_MD2_HEADER_SIZE  (17 * 4)
+#define TD_MD2_FRAME_HEADER (3 * 4 + 3 * 4 + 16)
+#define TD_MD2_SKIN_NAME    64
+
+enum
+{
+  HEADER_MAGIC,
+  HEADER_VERSION,
+  HEADER_SKIN_WIDTH,
+  HEADER_SKIN_HEIGHT,
+  HEADER_FRAME_SIZE,
+  HEADER_N_SKINS,
+  HEADER_N_VERTICES,
+  HEADER_N_ST,
+  HEADER_N_TRIANGLES,
+  HEADER_N_GL_COMMANDS,
+  HEADER_N_FRAMES,
+  HEADER_OFS_SKINS,
+  HEADER_OFS_ST,
+  HEADER_OFS_TRIANGLES,
+  HEADER_OFS_FRAMES,
+  HEADER_OFS_GL_COMMANDS,
+  HEADER_OFS_END
+};
+
+GQuark
+td_md2_file_error_quark (void)
+{
+  return g_quark_from_static_string ("td-md2-file-error-quark");
+}
+
+static guint32
+td_md2_file_read_uint32 (const guchar *p)
+{
+  guint32 v;
+
+  memcpy (&v, p, sizeof (v));
+
+  return GUINT32_FROM_LE (v);
+}
+
+static guint16
+td_md2_file_read_uint16 (const guchar *p)
+{
+  guint16 v;
+
+  memcpy (&v, p, sizeof (v));
+
+  return GUINT16_FROM_LE (v);
+}
+
+static float
+td_md2_file_read_float (const guchar *p)
+{
+  guint32 v = td_md2_file_read_uint32 (p);
+  float f;
+
+  memcpy (&f, &v, sizeof (f));
+
+  return f;
+}
+
+/* Checks that n_items of item_size starting at offset fit in the file */
+static gboolean
+td_md2_file_check_range (gsize length, guint32 offset,
+			 guint32 n_items, guint32 item_size)
+{
+  return (offset <= length
+	  && (item_size == 0 || n_items <= (length - offset) / item_size));
+}
+
+TDMD2File *
+td_md2_file_load (const char *filename, GError **error)
+{
+  gchar *contents;
+  gsize length;
+  const guchar *data;
+  guint32 header[HEADER_OFS_END + 1];
+  TDMD2File *file;
+  int i, j, k;
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  data = (const guchar *) contents;
+
+  if (length < TD_MD2_HEADER_SIZE)
+    goto invalid;
+
+  for (i = 0; i <= HEADER_OFS_END; i++)
+    header[i] = td_md2_file_read_uint32 (data + i * 4);
+
+  if (header[HEADER_MAGIC] != TD_MD2_FILE_MAGIC
+      || header[HEADER_VERSION] != TD_MD2_FILE_VERSION
+      /* Done in 64-bit so a huge vertex count can't wrap around */
+      || header[HEADER_FRAME_SIZE] < (TD_MD2_FRAME_HEADER
+				      + (guint64) header[HEADER_N_VERTICES] * 4)
+      || !td_md2_file_check_range (length, header[HEADER_OFS_ST],
+				   header[HEADER_N_ST], 4)
+      || !td_md2_file_check_range (length, header[HEADER_OFS_TRIANGLES],
+				   header[HEADER_N_TRIANGLES], 12)
+      || !td_md2_file_check_range (length, header[HEADER_OFS_FRAMES],
+				   header[HEADER_N_FRAMES],
+				   header[HEADER_FRAME_SIZE])
+      || !td_md2_file_check_range (length, header[HEADER_OFS_SKINS],
+				   header[HEADER_N_SKINS], TD_MD2_SKIN_NAME)
+      || header[HEADER_N_FRAMES] < 1)
+    goto invalid;
+
+  file = g_slice_new0 (TDMD2File);
+
+  file->skin_width = header[HEADER_SKIN_WIDTH];
+  file->skin_height = header[HEADER_SKIN_HEIGHT];
+  file->n_vertices = header[HEADER_N_VERTICES];
+
+  file->n_skins = header[HEADER_N_SKINS];
+  file->skins = g_new (char *, file->n_skins + 1);
+  for (i = 0; i < file->n_skins; i++)
+    file->skins[i] = g_strndup (contents + header[HEADER_OFS_SKINS]
+				+ i * TD_MD2_SKIN_NAME,
+				TD_MD2_SKIN_NAME);
+  file->skins[file->n_skins] = NULL;
+
+  file->n_st = header[HEADER_N_ST];
+  file->st = g_new (gint16, file->n_st * 2);
+  for (i = 0; i < file->n_st * 2; i++)
+    file->st[i] = td_md2_file_read_uint16 (data + header[HEADER_OFS_ST]
+					   + i * 2);
+
+  file->n_triangles = header[HEADER_N_TRIANGLES];
+  file->triangles = g_new (TDMD2Triangle, file->n_triangles);
+  for (i = 0; i < file->n_triangles; i++)
+    {
+      const guchar *p = data + header[HEADER_OFS_TRIANGLES] + i * 12;
+      TDMD2Triangle *triangle = file->triangles + i;
+
+      for (j = 0; j < 3; j++)
+	{
+	  triangle->vertices[j] = td_md2_file_read_uint16 (p + j * 2);
+	  triangle->st[j] = td_md2_file_read_uint16 (p + 6 + j * 2);
+
+	  if (triangle->vertices[j] >= file->n_vertices
+	      || triangle->st[j] >= file->n_st)
+	    {
+	      file->n_frames = 0;
+	      td_md2_file_free (file);
+	      goto invalid;
+	    }
+	}
+    }
+
+  file->n_frames = header[HEADER_N_FRAMES];
+  file->frames = g_new (TDMD2Frame, file->n_frames);
+  for (i = 0; i < file->n_frames; i++)
+    {
+      const guchar *p = (data + header[HEADER_OFS_FRAMES]
+			 + i * header[HEADER_FRAME_SIZE]);
+      TDMD2Frame *frame = file->frames + i;
+      float scale[3], translate[3];
+      float *v;
+
+      for (k = 0; k < 3; k++)
+	{
+	  scale[k] = td_md2_file_read_float (p + k * 4);
+	  translate[k] = td_md2_file_read_float (p + 12 + k * 4);
+	}
+
+      memcpy (frame->name, p + 24, 16);
+      frame->name[16] = '\0';
+
+      p += TD_MD2_FRAME_HEADER;
+
+      /* Each vertex is three compressed coordinates followed by an
+	 index into the normal table which we don't use */
+      v = frame->vertices = g_new (float, file->n_vertices * 3);
+      for (j = 0; j < file->n_vertices; j++, p += 4)
+	for (k = 0; k < 3; k++)
+	  *(v++) = p[k] * scale[k] + translate[k];
+    }
+
+  g_free (contents);
+
+  return file;
+
+ invalid:
+  g_set_error (error, TD_MD2_FILE_ERROR, TD_MD2_FILE_ERROR_INVALID,
+	       "%s is not a valid MD2 file", filename);
+  g_free (contents);
+
+  return NULL;
+}
+
+static void
+td_md2_file_append_uint32 (GByteArray *blob, guint32 v)
+{
+  v = GUINT32_TO_LE (v);
+  g_byte_array_append (blob, (const guint8 *) &v, sizeof (v));
+}
+
+static void
+td_md2_file_append_uint16 (GByteArray *blob, guint16 v)
+{
+  v = GUINT16_TO_LE (v);
+  g_byte_array_append (blob, (const guint8 *) &v, sizeof (v));
+}
+
+static void
+td_md2_file_append_float (GByteArray *blob, float f)
+{
+  guint32 v;
+
+  memcpy (&v, &f, sizeof (v));
+  td_md2_file_append_uint32 (blob, v);
+}
+
+/* Writes the file back out as an MD2. The vertices of each frame are
+   compressed again against their own box so they can move by up to
+   half a step. There are no GL commands or normals */
+gboolean
+td_md2_file_save (const TDMD2File *file,
+		  const char *filename,
+		  GError **error)
+{
+  GByteArray *blob = g_byte_array_new ();
+  guint32 header[HEADER_OFS_END + 1];
+  guint32 frame_size = TD_MD2_FRAME_HEADER + file->n_vertices * 4;
+  gboolean ret;
+  int i, j, k;
+
+  header[HEADER_MAGIC] = TD_MD2_FILE_MAGIC;
+  header[HEADER_VERSION] = TD_MD2_FILE_VERSION;
+  header[HEADER_SKIN_WIDTH] = file->skin_width;
+  header[HEADER_SKIN_HEIGHT] = file->skin_height;
+  header[HEADER_FRAME_SIZE] = frame_size;
+  header[HEADER_N_SKINS] = file->n_skins;
+  header[HEADER_N_VERTICES] = file->n_vertices;
+  header[HEADER_N_ST] = file->n_st;
+  header[HEADER_N_TRIANGLES] = file->n_triangles;
+  header[HEADER_N_GL_COMMANDS] = 0;
+  header[HEADER_N_FRAMES] = file->n_frames;
+  header[HEADER_OFS_SKINS] = TD_MD2_HEADER_SIZE;
+  header[HEADER_OFS_ST] = (header[HEADER_OFS_SKINS]
+			   + file->n_skins * TD_MD2_SKIN_NAME);
+  header[HEADER_OFS_TRIANGLES] = header[HEADER_OFS_ST] + file->n_st * 4;
+  header[HEADER_OFS_FRAMES] = (header[HEADER_OFS_TRIANGLES]
+			       + file->n_triangles * 12);
+  header[HEADER_OFS_GL_COMMANDS] = (header[HEADER_OFS_FRAMES]
+				    + file->n_frames * frame_size);
+  header[HEADER_OFS_END] = header[HEADER_OFS_GL_COMMANDS];
+
+  for (i = 0; i <= HEADER_OFS_END; i++)
+    td_md2_file_append_uint32 (blob, header[i]);
+
+  for (i = 0; i < file->n_skins; i++)
+    {
+      char name[TD_MD2_SKIN_NAME];
+
+      memset (name, 0, sizeof (name));
+      strncpy (name, file->skins[i], sizeof (name) - 1);
+      g_byte_array_append (blob, (const guint8 *) name, sizeof (name));
+    }
+
+  for (i = 0; i < file->n_st * 2; i++)
+    td_md2_file_append_uint16 (blob, file->st[i]);
+
+  for (i = 0; i < file->n_triangles; i++)
+    {
+      for (j = 0; j < 3; j++)
+	td_md2_file_append_uint16 (blob, file->triangles[i].vertices[j]);
+      for (j = 0; j < 3; j++)
+	td_md2_file_append_uint16 (blob, file->triangles[i].st[j]);
+    }
+
+  for (i = 0; i < file->n_frames; i++)
+    {
+      const TDMD2Frame *frame = file->frames + i;
+      float min[3], max[3], scale[3];
+      char name[16];
+
+      for (k = 0; k < 3; k++)
+	min[k] = max[k] = file->n_vertices > 0 ? frame->vertices[k] : 0.0f;
+      for (j = 0; j < file->n_vertices; j++)
+	for (k = 0; k < 3; k++)
+	  {
+	    min[k] = MIN (min[k], frame->vertices[j * 3 + k]);
+	    max[k] = MAX (max[k], frame->vertices[j * 3 + k]);
+	  }
+
+      for (k = 0; k < 3; k++)
+	{
+	  scale[k] = (max[k] - min[k]) / 255.0f;
+	  td_md2_file_append_float (blob, scale[k]);
+	}
+      for (k = 0; k < 3; k++)
+	td_md2_file_append_float (blob, min[k]);
+
+      memcpy (name, frame->name, sizeof (name));
+      g_byte_array_append (blob, (const guint8 *) name, sizeof (name));
+
+      for (j = 0; j < file->n_vertices; j++)
+	{
+	  guint8 packed[4] = { 0, 0, 0, 0 };
+
+	  for (k = 0; k < 3; k++)
+	    if (scale[k] > 0.0f)
+	      packed[k] = ((frame->vertices[j * 3 + k] - min[k]) / scale[k]
+			   + 0.5f);
+
+	  g_byte_array_append (blob, packed, sizeof (packed));
+	}
+    }
+
+  ret = g_file_set_contents (filename, (const gchar *) blob->data,
+			     blob->len, error);
+
+  g_byte_array_free (blob, TRUE);
+
+  return ret;
+}
+
+void
+td_md2_file_free (TDMD2File *file)
+{
+  int i;
+
+  for (i = 0; i < file->n_frames; i++)
+    g_free (file->frames[i].vertices);
+
+  g_free (file->frames);
+  g_free (file->triangles);
+  g_free (file->st);
+  g_strfreev (file->skins);
+
+  g_slice_free (TDMD2File, file);
+}
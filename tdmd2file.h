@@ -0,0 +1,90 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_MD2_FILE_H
+#define _HAVE_TD_MD2_FILE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define TD_MD2_FILE_ERROR (td_md2_file_error_quark ())
+
+typedef enum
+{
+  TD_MD2_FILE_ERROR_INVALID
+} TDMD2FileError;
+
+typedef struct _TDMD2File     TDMD2File;
+typedef struct _TDMD2Frame    TDMD2Frame;
+typedef struct _TDMD2Triangle TDMD2Triangle;
+
+struct _TDMD2Frame
+{
+  char name[17];
+  /* Decoded positions of the vertices as x, y, z triplets */
+  float *vertices;
+};
+
+struct _TDMD2Triangle
+{
+  guint16 vertices[3];
+  guint16 st[3];
+};
+
+/* The contents of an MD2 file unpacked into native types */
+struct _TDMD2File
+{
+  int skin_width, skin_height;
+
+  /* Names of the skins stored in the file. These are usually relative
+     to the directory containing the model */
+  int n_skins;
+  char **skins;
+
+  int n_vertices;
+
+  int n_st;
+  /* s, t pairs in texels */
+  gint16 *st;
+
+  int n_triangles;
+  TDMD2Triangle *triangles;
+
+  int n_frames;
+  TDMD2Frame *frames;
+};
+
+GQuark td_md2_file_error_quark (void);
+
+TDMD2File *td_md2_file_load (const char *filename, GError **error);
+gboolean td_md2_file_save (const TDMD2File *file,
+			   const char *filename,
+			   GError **error);
+void td_md2_file_free (TDMD2File *file);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_MD2_FILE_H */
@@ -0,0 +1,262 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <string.h>
+
+#include "tdmodel.h"
+#include "tdskinremap.h"
+
+/* Creates an empty model. The arrays need to be filled in by the
+   caller */
+TDModel *
+td_model_new (void)
+{
+  TDModel *model = g_slice_new0 (TDModel);
+
+  model->ref_count = 1;
+  model->allocations = g_ptr_array_new ();
+  model->skins = g_new (const guint8 *, 1);
+  model->sources = g_new0 (char *, 1);
+
+  return model;
+}
+
+/* Remembers that mem belongs to the model and returns it */
+static gpointer
+td_model_take (TDModel *model, gpointer mem)
+{
+  g_ptr_array_add (model->allocations, mem);
+
+  return mem;
+}
+
+static void
+td_model_add_source (TDModel *model, const char *filename)
+{
+  int n_sources = g_strv_length (model->sources);
+
+  model->sources = g_renew (char *, model->sources, n_sources + 2);
+  model->sources[n_sources] = g_strdup (filename);
+  model->sources[n_sources + 1] = NULL;
+}
+
+TDModel *
+td_model_new_from_md2_file (const TDMD2File *file)
+{
+  TDModel *model = td_model_new ();
+  float *tex_coords, *vertices;
+  int frame, i, j, k;
+
+  model->n_frames = file->n_frames;
+  model->n_vertices = file->n_triangles * 3;
+
+  tex_coords = td_model_take (model, g_new (float, model->n_vertices * 2));
+  model->tex_coords = tex_coords;
+
+  for (i = 0; i < file->n_triangles; i++)
+    for (j = 0; j < 3; j++)
+      {
+	const gint16 *st = file->st + file->triangles[i].st[j] * 2;
+
+	*(tex_coords++) = st[0] / (float) file->skin_width;
+	*(tex_coords++) = st[1] / (float) file->skin_height;
+      }
+
+  vertices = td_model_take (model, g_new (float, (model->n_frames
+						  * model->n_vertices * 3)));
+  model->vertices = vertices;
+
+  for (k = 0; k < 3; k++)
+    {
+      model->min[k] = G_MAXFLOAT;
+      model->max[k] = -G_MAXFLOAT;
+    }
+
+  for (frame = 0; frame < file->n_frames; frame++)
+    for (i = 0; i < file->n_triangles; i++)
+      for (j = 0; j < 3; j++)
+	{
+	  const float *v = (file->frames[frame].vertices
+			    + file->triangles[i].vertices[j] * 3);
+
+	  for (k = 0; k < 3; k++)
+	    {
+	      model->min[k] = MIN (model->min[k], v[k]);
+	      model->max[k] = MAX (model->max[k], v[k]);
+	      *(vertices++) = v[k];
+	    }
+	}
+
+  model->hit_boxes = td_hit_boxes_new (file);
+
+  return model;
+}
+
+/* Loads an MD2 file along with the skins that it names */
+TDModel *
+td_model_load (const char *filename, GError **error)
+{
+  TDMD2File *file;
+  TDModel *model;
+  char *dir;
+  int i;
+
+  if ((file = td_md2_file_load (filename, error)) == NULL)
+    return NULL;
+
+  model = td_model_new_from_md2_file (file);
+  td_model_add_source (model, filename);
+
+  dir = g_path_get_dirname (filename);
+
+  for (i = 0; i < file->n_skins; i++)
+    {
+      char *skin_filename = g_build_filename (dir, file->skins[i], NULL);
+      gboolean ret = td_model_add_skin (model, skin_filename, error);
+
+      g_free (skin_filename);
+
+      if (!ret)
+	{
+	  td_model_unref (model);
+	  model = NULL;
+	  break;
+	}
+    }
+
+  g_free (dir);
+  td_md2_file_free (file);
+
+  return model;
+}
+
+gboolean
+td_model_add_skin (TDModel *model, const char *filename, GError **error)
+{
+  GdkPixbuf *pixbuf, *rgba;
+  int width, height, rowstride, y;
+  const guchar *src;
+  guint8 *texels;
+
+  if ((pixbuf = gdk_pixbuf_new_from_file (filename, error)) == NULL)
+    return FALSE;
+
+  /* Upload always wants four bytes per texel */
+  rgba = gdk_pixbuf_add_alpha (pixbuf, FALSE, 0, 0, 0);
+  g_object_unref (pixbuf);
+
+  width = gdk_pixbuf_get_width (rgba);
+  height = gdk_pixbuf_get_height (rgba);
+
+  if (model->n_skins == 0)
+    {
+      model->skin_width = width;
+      model->skin_height = height;
+    }
+  else if (width != model->skin_width || height != model->skin_height)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_FAILED,
+		   "%s is not the same size as the other skins", filename);
+      g_object_unref (rgba);
+      return FALSE;
+    }
+
+  rowstride = gdk_pixbuf_get_rowstride (rgba);
+  src = gdk_pixbuf_get_pixels (rgba);
+  texels = td_model_take (model, g_malloc (width * height * 4));
+
+  for (y = 0; y < height; y++)
+    memcpy (texels + y * width * 4, src + y * rowstride, width * 4);
+
+  g_object_unref (rgba);
+
+  model->skins = g_renew (const guint8 *, model->skins, model->n_skins + 2);
+  model->skins[model->n_skins++] = texels;
+
+  td_model_add_source (model, filename);
+
+  return TRUE;
+}
+
+/* Adds a colour variant of an existing skin generated with remap.
+   This is done every time the model is loaded instead of being stored
+   so a variant costs no more than a table of a few entries on disk */
+int
+td_model_add_skin_variant (TDModel *model,
+			   int base_skin,
+			   const TDSkinRemap *remap)
+{
+  guint8 *texels;
+  int n_pixels = model->skin_width * model->skin_height;
+
+  g_return_val_if_fail (base_skin >= 0 && base_skin < model->n_skins, -1);
+
+  texels = td_model_take (model, g_malloc (n_pixels * 4));
+  td_skin_remap_apply (remap, model->skins[base_skin], texels, n_pixels);
+
+  model->skins = g_renew (const guint8 *, model->skins, model->n_skins + 2);
+  model->skins[model->n_skins] = texels;
+
+  return model->n_skins++;
+}
+
+const float *
+td_model_get_frame (const TDModel *model, int frame)
+{
+  frame = CLAMP (frame, 0, model->n_frames - 1);
+
+  return model->vertices + frame * model->n_vertices * 3;
+}
+
+TDModel *
+td_model_ref (TDModel *model)
+{
+  model->ref_count++;
+
+  return model;
+}
+
+void
+td_model_unref (TDModel *model)
+{
+  if (--model->ref_count <= 0)
+    {
+      g_ptr_array_foreach (model->allocations, (GFunc) g_free, NULL);
+      g_ptr_array_free (model->allocations, TRUE);
+
+      if (model->mapped_file)
+	g_mapped_file_free (model->mapped_file);
+
+      if (model->hit_boxes)
+	td_hit_boxes_free (model->hit_boxes);
+
+      g_free (model->skins);
+      g_strfreev (model->sources);
+
+      g_slice_free (TDModel, model);
+    }
+}
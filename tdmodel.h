@@ -0,0 +1,92 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_MODEL_H
+#define _HAVE_TD_MODEL_H
+
+#include <glib.h>
+
+#include "tdmd2file.h"
+#include "tdhitboxes.h"
+#include "tdskinremap.h"
+
+G_BEGIN_DECLS
+
+typedef struct _TDModel TDModel;
+
+/* An MD2 model unpacked into arrays that can be handed straight to
+   GL. Every triangle has its own three vertices so a keyframe can be
+   drawn with a single glDrawArrays. The arrays either belong to the
+   model or point into a mapped asset cache */
+struct _TDModel
+{
+  int n_frames;
+  int n_vertices;
+
+  /* s, t pairs normalized to the size of the skin */
+  const float *tex_coords;
+  /* x, y, z triplets for each vertex of every frame one after the
+     other */
+  const float *vertices;
+
+  /* Box around every frame of the animation */
+  float min[3], max[3];
+
+  TDHitBoxes *hit_boxes;
+
+  /* Every skin is unpremultiplied RGBA of the same size */
+  int skin_width, skin_height;
+  int n_skins;
+  const guint8 **skins;
+
+  /* Every file the model was built from, NULL terminated */
+  char **sources;
+
+  /*< private >*/
+  int ref_count;
+  /* Memory that needs to be freed along with the model */
+  GPtrArray *allocations;
+  GMappedFile *mapped_file;
+};
+
+TDModel *td_model_new (void);
+TDModel *td_model_new_from_md2_file (const TDMD2File *file);
+TDModel *td_model_load (const char *filename, GError **error);
+
+gboolean td_model_add_skin (TDModel *model,
+			    const char *filename,
+			    GError **error);
+int td_model_add_skin_variant (TDModel *model,
+			       int base_skin,
+			       const TDSkinRemap *remap);
+
+const float *td_model_get_frame (const TDModel *model, int frame);
+
+TDModel *td_model_ref (TDModel *model);
+void td_model_unref (TDModel *model);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_MODEL_H */
@@ -0,0 +1,350 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "tdmodelcache.h"
+
+/* The cache is a single blob holding everything that the renderer
+   needs so that it can be mapped and used in place. It is baked on
+   the machine that uses it so everything is in the native byte
+   order. The magic number reads differently on the wrong byte
+   order. Bump the version whenever the layout changes */
+#define TD_MODEL_CACHE_MAGIC   0x434d4454 /* "TDMC" */
+#define TD_MODEL_CACHE_VERSION 1
+
+/* Every section starts on a boundary of this many bytes */
+#define TD_MODEL_CACHE_ALIGN   16
+
+typedef struct _TDModelCacheHeader TDModelCacheHeader;
+typedef struct _TDModelCacheSource TDModelCacheSource;
+
+struct _TDModelCacheHeader
+{
+  guint32 magic, version;
+
+  guint32 n_frames, n_vertices;
+  guint32 skin_width, skin_height, n_skins;
+  guint32 n_sources;
+
+  float min[3], max[3];
+
+  /* Byte offsets of each section from the start of the file */
+  guint32 ofs_sources;
+  guint32 ofs_tex_coords;
+  guint32 ofs_vertices;
+  guint32 ofs_hit_boxes;
+  guint32 ofs_skins;
+  guint32 file_size;
+};
+
+/* Each source is followed by its NUL terminated filename padded to
+   a multiple of 8 bytes */
+struct _TDModelCacheSource
+{
+  guint64 size;
+  gint64 mtime;
+  guint32 name_size;
+  guint32 padding;
+};
+
+GQuark
+td_model_cache_error_quark (void)
+{
+  return g_quark_from_static_string ("td-model-cache-error-quark");
+}
+
+static gboolean
+td_model_cache_get_stat (const char *filename,
+			 TDModelCacheSource *source)
+{
+  struct stat buf;
+
+  if (g_stat (filename, &buf) == -1)
+    return FALSE;
+
+  source->size = buf.st_size;
+  source->mtime = buf.st_mtime;
+
+  return TRUE;
+}
+
+/* Checks that a section fits in the file */
+static gboolean
+td_model_cache_check_range (const TDModelCacheHeader *header,
+			    guint32 offset, guint64 size)
+{
+  return (offset % TD_MODEL_CACHE_ALIGN == 0
+	  && offset <= header->file_size
+	  && size <= header->file_size - offset);
+}
+
+static void
+td_model_cache_append (GByteArray *blob, gconstpointer data, gsize size)
+{
+  g_byte_array_append (blob, data, size);
+}
+
+static guint32
+td_model_cache_align (GByteArray *blob, gsize alignment)
+{
+  static const guint8 zeroes[TD_MODEL_CACHE_ALIGN] = { 0 };
+
+  if (blob->len % alignment)
+    g_byte_array_append (blob, zeroes, alignment - blob->len % alignment);
+
+  return blob->len;
+}
+
+gboolean
+td_model_cache_save (const TDModel *model,
+		     const char *filename,
+		     GError **error)
+{
+  TDModelCacheHeader header;
+  GByteArray *blob;
+  gsize skin_size = model->skin_width * model->skin_height * 4;
+  gboolean ret;
+  int i;
+
+  memset (&header, 0, sizeof (header));
+  header.magic = TD_MODEL_CACHE_MAGIC;
+  header.version = TD_MODEL_CACHE_VERSION;
+  header.n_frames = model->n_frames;
+  header.n_vertices = model->n_vertices;
+  header.skin_width = model->skin_width;
+  header.skin_height = model->skin_height;
+  header.n_skins = model->n_skins;
+  header.n_sources = g_strv_length (model->sources);
+  memcpy (header.min, model->min, sizeof (header.min));
+  memcpy (header.max, model->max, sizeof (header.max));
+
+  blob = g_byte_array_new ();
+
+  /* The header is written again once the offsets are known */
+  td_model_cache_append (blob, &header, sizeof (header));
+
+  header.ofs_sources = td_model_cache_align (blob, TD_MODEL_CACHE_ALIGN);
+  for (i = 0; model->sources[i]; i++)
+    {
+      TDModelCacheSource source;
+
+      memset (&source, 0, sizeof (source));
+
+      /* Remember the size and modification time of the file so that
+	 the loader can tell when the cache is stale */
+      if (!td_model_cache_get_stat (model->sources[i], &source))
+	{
+	  g_set_error (error, TD_MODEL_CACHE_ERROR,
+		       TD_MODEL_CACHE_ERROR_STALE,
+		       "%s: %s", model->sources[i], g_strerror (errno));
+	  g_byte_array_free (blob, TRUE);
+	  return FALSE;
+	}
+
+      source.name_size = strlen (model->sources[i]) + 1;
+      td_model_cache_append (blob, &source, sizeof (source));
+      td_model_cache_append (blob, model->sources[i], source.name_size);
+      td_model_cache_align (blob, 8);
+    }
+
+  header.ofs_tex_coords = td_model_cache_align (blob, TD_MODEL_CACHE_ALIGN);
+  td_model_cache_append (blob, model->tex_coords,
+			 model->n_vertices * 2 * sizeof (float));
+
+  header.ofs_vertices = td_model_cache_align (blob, TD_MODEL_CACHE_ALIGN);
+  td_model_cache_append (blob, model->vertices,
+			 (model->n_frames * model->n_vertices
+			  * 3 * sizeof (float)));
+
+  header.ofs_hit_boxes = td_model_cache_align (blob, TD_MODEL_CACHE_ALIGN);
+  td_model_cache_append (blob, model->hit_boxes->frames,
+			 model->hit_boxes->n_frames * sizeof (TDHitBox));
+
+  header.ofs_skins = td_model_cache_align (blob, TD_MODEL_CACHE_ALIGN);
+  for (i = 0; i < model->n_skins; i++)
+    td_model_cache_append (blob, model->skins[i], skin_size);
+
+  header.file_size = blob->len;
+  memcpy (blob->data, &header, sizeof (header));
+
+  ret = g_file_set_contents (filename, (const gchar *) blob->data,
+			     blob->len, error);
+
+  g_byte_array_free (blob, TRUE);
+
+  return ret;
+}
+
+/* Checks that the cache was baked from the files that the caller
+   would otherwise load and that none of them have changed since */
+static gboolean
+td_model_cache_check_sources (const TDModelCacheHeader *header,
+			      const char *data,
+			      char **sources,
+			      const char *model_filename,
+			      const char * const *extra_skins)
+{
+  guint32 offset = header->ofs_sources;
+  int n_extra_skins = extra_skins ? g_strv_length ((char **) extra_skins) : 0;
+  int i;
+
+  for (i = 0; i < header->n_sources; i++)
+    {
+      TDModelCacheSource source, current;
+      const char *name;
+
+      if (!td_model_cache_check_range (header, offset, sizeof (source)))
+	return FALSE;
+      memcpy (&source, data + offset, sizeof (source));
+      offset += sizeof (source);
+
+      name = data + offset;
+      if (source.name_size < 1
+	  || source.name_size > header->file_size - offset
+	  || name[source.name_size - 1] != '\0')
+	return FALSE;
+      offset += (source.name_size + 7) & ~7;
+
+      if (!td_model_cache_get_stat (name, &current)
+	  || current.size != source.size
+	  || current.mtime != source.mtime)
+	return FALSE;
+
+      sources[i] = g_strdup (name);
+    }
+
+  /* The model is always the first source and any extra skins are
+     added last */
+  if (header->n_sources < 1 + n_extra_skins
+      || strcmp (sources[0], model_filename))
+    return FALSE;
+
+  for (i = 0; i < n_extra_skins; i++)
+    if (strcmp (sources[header->n_sources - n_extra_skins + i],
+		extra_skins[i]))
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Maps a cache baked from model_filename followed by extra_skins. The
+   model's arrays point directly into the mapping */
+TDModel *
+td_model_cache_load (const char *filename,
+		     const char *model_filename,
+		     const char * const *extra_skins,
+		     GError **error)
+{
+  GMappedFile *mapped_file;
+  const char *data;
+  TDModelCacheHeader header;
+  guint64 skin_size;
+  char **sources;
+  TDModel *model;
+  int i;
+
+  if ((mapped_file = g_mapped_file_new (filename, FALSE, error)) == NULL)
+    return NULL;
+
+  data = g_mapped_file_get_contents (mapped_file);
+
+  if (g_mapped_file_get_length (mapped_file) < sizeof (header))
+    goto invalid;
+
+  memcpy (&header, data, sizeof (header));
+  skin_size = (guint64) header.skin_width * header.skin_height * 4;
+
+  if (header.magic != TD_MODEL_CACHE_MAGIC
+      || header.version != TD_MODEL_CACHE_VERSION
+      || header.file_size != g_mapped_file_get_length (mapped_file)
+      || header.n_frames < 1
+      || !td_model_cache_check_range (&header, header.ofs_sources, 0)
+      || !td_model_cache_check_range (&header, header.ofs_tex_coords,
+				      (guint64) header.n_vertices
+				      * 2 * sizeof (float))
+      || !td_model_cache_check_range (&header, header.ofs_vertices,
+				      (guint64) header.n_frames
+				      * header.n_vertices
+				      * 3 * sizeof (float))
+      || !td_model_cache_check_range (&header, header.ofs_hit_boxes,
+				      (guint64) header.n_frames
+				      * sizeof (TDHitBox))
+      || !td_model_cache_check_range (&header, header.ofs_skins,
+				      header.n_skins * skin_size))
+    goto invalid;
+
+  sources = g_new0 (char *, header.n_sources + 1);
+
+  if (!td_model_cache_check_sources (&header, data, sources,
+				     model_filename, extra_skins))
+    {
+      g_strfreev (sources);
+      g_set_error (error, TD_MODEL_CACHE_ERROR, TD_MODEL_CACHE_ERROR_STALE,
+		   "%s is out of date", filename);
+      g_mapped_file_free (mapped_file);
+      return NULL;
+    }
+
+  model = td_model_new ();
+  model->mapped_file = mapped_file;
+
+  g_strfreev (model->sources);
+  model->sources = sources;
+
+  model->n_frames = header.n_frames;
+  model->n_vertices = header.n_vertices;
+  model->tex_coords = (const float *) (data + header.ofs_tex_coords);
+  model->vertices = (const float *) (data + header.ofs_vertices);
+  memcpy (model->min, header.min, sizeof (model->min));
+  memcpy (model->max, header.max, sizeof (model->max));
+
+  model->hit_boxes
+    = td_hit_boxes_new_from_boxes (header.n_frames,
+				   (const TDHitBox *)
+				   (data + header.ofs_hit_boxes));
+
+  model->skin_width = header.skin_width;
+  model->skin_height = header.skin_height;
+  model->n_skins = header.n_skins;
+  model->skins = g_renew (const guint8 *, model->skins, header.n_skins + 1);
+  for (i = 0; i < header.n_skins; i++)
+    model->skins[i] = ((const guint8 *) data + header.ofs_skins
+		       + i * skin_size);
+
+  return model;
+
+ invalid:
+  g_set_error (error, TD_MODEL_CACHE_ERROR, TD_MODEL_CACHE_ERROR_INVALID,
+	       "%s is not a valid model cache", filename);
+  g_mapped_file_free (mapped_file);
+
+  return NULL;
+}
@@ -0,0 +1,55 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_MODEL_CACHE_H
+#define _HAVE_TD_MODEL_CACHE_H
+
+#include <glib.h>
+
+#include "tdmodel.h"
+
+G_BEGIN_DECLS
+
+#define TD_MODEL_CACHE_ERROR (td_model_cache_error_quark ())
+
+typedef enum
+{
+  TD_MODEL_CACHE_ERROR_INVALID,
+  TD_MODEL_CACHE_ERROR_STALE
+} TDModelCacheError;
+
+GQuark td_model_cache_error_quark (void);
+
+TDModel *td_model_cache_load (const char *filename,
+			      const char *model_filename,
+			      const char * const *extra_skins,
+			      GError **error);
+gboolean td_model_cache_save (const TDModel *model,
+			      const char *filename,
+			      GError **error);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_MODEL_CACHE_H */
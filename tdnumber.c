@@ -25,10 +25,15 @@
 
 #include <clutter/clutter-actor.h>
 #include <cogl/cogl.h>
-#include <cairo.h>
-#include <string.h>
+/* The digits are only batched with GL directly on big GL. GLES has no
+   quads or attribute stack so Cogl draws them instead */
+#ifdef HAVE_COGL_GL
+#include <GL/gl.h>
+#endif
 
 #include "tdnumber.h"
+#include "tdnumberatlas.h"
+#include "tdprofiler.h"
 
 #define TD_NUMBER_GET_PRIVATE(obj) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), TD_TYPE_NUMBER, TDNumberPrivate))
@@ -47,31 +52,100 @@ static void td_number_get_preferred_height (ClutterActor *self,
 					    ClutterUnit  *min_height_p,
 					    ClutterUnit  *natural_height_p);
 
-#define TD_NUMBER_TEX_SIZE 256
-#define TD_NUMBER_GAP      8
+typedef struct _TDNumberShared TDNumberShared;
 
-typedef struct _TDNumberBox TDNumberBox;
-
-struct _TDNumberBox
+/* The texture with the digits is shared between all instances */
+struct _TDNumberShared
 {
-  ClutterFixed tx1, ty1;
-  ClutterFixed tx2, ty2;
+  int ref_count;
+
+  /* Only the metrics are kept. The pixels are freed once they are
+     uploaded */
+  TDNumberAtlas *atlas;
 
-  int width, height, advance, y_off;
+  CoglHandle tex;
+#ifdef HAVE_COGL_GL
+  /* The GL texture if all of the digits can be drawn in a single
+     batch, otherwise 0 */
+  GLuint gl_tex;
+#endif
 };
 
 struct _TDNumberPrivate
 {
-  CoglHandle tex;
-
-  TDNumberBox boxes[10];
-
-  int max_ascent;
+  TDNumberShared *shared;
 
   int value;
-  char digits[16];
+
+  /* The quads for the current value. This is only rebuilt when the
+     value changes */
+  TDNumberLayout layout;
 };
 
+static TDNumberShared *td_number_shared = NULL;
+
+static TDNumberShared *
+td_number_shared_ref (void)
+{
+  TDNumberShared *shared = td_number_shared;
+
+  if (shared == NULL)
+    {
+      TDNumberAtlas *atlas = td_number_atlas_new ();
+#ifdef HAVE_COGL_GL
+      GLuint gl_tex;
+      GLenum gl_target;
+#endif
+
+      shared = td_number_shared = g_slice_new (TDNumberShared);
+      shared->ref_count = 0;
+      shared->atlas = atlas;
+
+      /* Upload the image to a texture */
+      shared->tex = cogl_texture_new_from_data (atlas->size,
+						atlas->size,
+						64,
+						FALSE,
+						COGL_PIXEL_FORMAT_RGBA_8888,
+						COGL_PIXEL_FORMAT_RGBA_8888,
+						atlas->size * 4,
+						atlas->pixels);
+
+      g_free (atlas->pixels);
+      atlas->pixels = NULL;
+
+#ifdef HAVE_COGL_GL
+      /* The batched drawing needs a single normalized GL texture */
+      shared->gl_tex = 0;
+      if (shared->tex != COGL_INVALID_HANDLE
+	  && !cogl_texture_is_sliced (shared->tex)
+	  && cogl_texture_get_gl_texture (shared->tex, &gl_tex, &gl_target)
+	  && gl_target == GL_TEXTURE_2D)
+	shared->gl_tex = gl_tex;
+#endif
+    }
+
+  shared->ref_count++;
+
+  return shared;
+}
+
+static void
+td_number_shared_unref (TDNumberShared *shared)
+{
+  if (--shared->ref_count <= 0)
+    {
+      if (shared->tex != COGL_INVALID_HANDLE)
+	cogl_texture_unref (shared->tex);
+
+      td_number_atlas_free (shared->atlas);
+
+      g_slice_free (TDNumberShared, shared);
+
+      td_number_shared = NULL;
+    }
+}
+
 static void
 td_number_class_init (TDNumberClass *klass)
 {
@@ -91,168 +165,101 @@ static void
 td_number_init (TDNumber *self)
 {
   TDNumberPrivate *priv;
-  cairo_t *cr;
-  cairo_surface_t *surface;
-  int xpos = 0, ypos = 0;
-  int row_height = 0;
-  unsigned char *image_data, *p;
-  int stride, i;
 
   self->priv = priv = TD_NUMBER_GET_PRIVATE (self);
 
-  priv->value = 0;
-  priv->digits[0] = '0';
-  priv->digits[1] = '\0';
-  priv->max_ascent = 0;
-
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
-					TD_NUMBER_TEX_SIZE,
-					TD_NUMBER_TEX_SIZE);
-
-  cr = cairo_create (surface);
-
-  cairo_set_line_width (cr, 4.0);
-
-  cairo_set_font_size (cr, 40.0);
-
-  for (i = 0; i < 10; i++)
-    {
-      char digit_str[2] = { i + '0', '\0' };
-      cairo_text_extents_t extents;
-      TDNumberBox *box = priv->boxes + i;
-
-      cairo_text_extents (cr, digit_str, &extents);
-
-      box->width = extents.width + TD_NUMBER_GAP;
-      box->height = extents.height + TD_NUMBER_GAP;
-      box->advance = extents.x_advance + 2;
-      box->y_off = -extents.y_bearing;
-
-      if (box->y_off > priv->max_ascent)
-	priv->max_ascent = box->y_off;
-
-      if (xpos + box->width > TD_NUMBER_TEX_SIZE)
-	{
-	  xpos = 0;
-	  ypos += row_height;
-	}
+  priv->shared = td_number_shared_ref ();
 
-      box->tx1 = CFX_QDIV (CLUTTER_INT_TO_FIXED (xpos),
-			   CLUTTER_INT_TO_FIXED (TD_NUMBER_TEX_SIZE));
-      box->tx2 = box->tx1
-	+ CFX_QDIV (CLUTTER_INT_TO_FIXED (box->width),
-		    CLUTTER_INT_TO_FIXED (TD_NUMBER_TEX_SIZE));
-
-      box->ty1 = CFX_QDIV (CLUTTER_INT_TO_FIXED (ypos),
-			   CLUTTER_INT_TO_FIXED (TD_NUMBER_TEX_SIZE));
-      box->ty2 = box->ty1
-	+ CFX_QDIV (CLUTTER_INT_TO_FIXED (box->height),
-		    CLUTTER_INT_TO_FIXED (TD_NUMBER_TEX_SIZE));
-
-      cairo_move_to (cr, xpos - extents.x_bearing + TD_NUMBER_GAP / 2, 
-		     ypos - extents.y_bearing + TD_NUMBER_GAP / 2);
-
-      cairo_text_path (cr, digit_str);
-
-      /* Draw an outline in black */
-      cairo_set_source_rgb (cr, 0.0, 0.0, 0.0);
-      cairo_stroke_preserve (cr);
-
-      /* Fill in the shape in white */
-      cairo_set_source_rgb (cr, 0.4, 0.4, 0.8);
-      cairo_fill (cr);
-
-      if (box->height > row_height)
-	row_height = box->height;
+  priv->value = 0;
+  td_number_atlas_layout (priv->shared->atlas, priv->value, &priv->layout);
+}
 
-      xpos += box->width;
-    }
+ClutterActor *
+td_number_new (void)
+{
+  return g_object_new (TD_TYPE_NUMBER, NULL);
+}
 
-  priv->max_ascent += TD_NUMBER_GAP / 2;
+#ifdef HAVE_COGL_GL
+static void
+td_number_paint_batched (TDNumber *num)
+{
+  TDNumberPrivate *priv = num->priv;
+  const TDNumberVertex *v = priv->layout.vertices;
 
-  cairo_destroy (cr);
+  glPushAttrib (GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT);
+  glPushClientAttrib (GL_CLIENT_VERTEX_ARRAY_BIT);
 
-  image_data = cairo_image_surface_get_data (surface);
-  stride = cairo_image_surface_get_stride (surface);
+  glEnable (GL_TEXTURE_2D);
+  glBindTexture (GL_TEXTURE_2D, priv->shared->gl_tex);
+  glEnable (GL_BLEND);
+  glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  /* Convert the image from cairo format to RGBA */
-  for (p = image_data + TD_NUMBER_TEX_SIZE * stride; p > image_data;)
-    {
-      p -= stride - TD_NUMBER_TEX_SIZE * 4;
-      
-      for (i = 0; i < TD_NUMBER_TEX_SIZE; i++)
-	{
-	  guint32 v = *(guint32 *) (p -= sizeof (guint32));
-	  guchar alpha = v >> 24;
-
-	  if (alpha == 0)
-	    memset (p, 0, sizeof (guint32));
-	  else
-	    {
-	      p[0] = ((v >> 16) & 0xff) * 255 / alpha;
-	      p[1] = ((v >> 8) & 0xff) * 255 / alpha;
-	      p[2] = (v & 0xff) * 255 / alpha;
-	      p[3] = alpha;
-	    }
-	}
-    }
+  glEnableClientState (GL_VERTEX_ARRAY);
+  glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState (GL_COLOR_ARRAY);
+  glVertexPointer (2, GL_FLOAT, sizeof (TDNumberVertex), &v->x);
+  glTexCoordPointer (2, GL_FLOAT, sizeof (TDNumberVertex), &v->s);
 
-  /* Upload the image to a texture */
-  priv->tex = cogl_texture_new_from_data (TD_NUMBER_TEX_SIZE,
-					  TD_NUMBER_TEX_SIZE,
-					  64,
-					  FALSE,
-					  COGL_PIXEL_FORMAT_RGBA_8888,
-					  COGL_PIXEL_FORMAT_RGBA_8888,
-					  stride,
-					  image_data);
-
-  cairo_surface_destroy (surface);
-}
+  glDrawArrays (GL_QUADS, 0, priv->layout.n_digits * 4);
 
-ClutterActor *
-td_number_new (void)
-{
-  return g_object_new (TD_TYPE_NUMBER, NULL);
+  glPopClientAttrib ();
+  glPopAttrib ();
 }
+#endif /* HAVE_COGL_GL */
 
 static void
-td_number_paint (ClutterActor *self)
+td_number_do_paint (ClutterActor *self)
 {
   TDNumber *num = TD_NUMBER (self);
   TDNumberPrivate *priv = num->priv;
-  char *p;
-  int xpos = 0;
+  const TDNumberVertex *v;
+  int i;
   static const ClutterColor white = { 0xff, 0xff, 0xff, 0xff };
 
-  if (priv->tex == COGL_INVALID_HANDLE)
+  if (priv->shared->tex == COGL_INVALID_HANDLE)
     return;
 
   cogl_color (&white);
 
-  for (p = priv->digits; *p; p++)
+#ifdef HAVE_COGL_GL
+  if (priv->shared->gl_tex)
     {
-      TDNumberBox *box = priv->boxes + *p - '0';
-
-      cogl_texture_rectangle (priv->tex,
-			      CLUTTER_INT_TO_FIXED (xpos),
-			      CLUTTER_INT_TO_FIXED (priv->max_ascent
-						    - box->y_off),
-			      CLUTTER_INT_TO_FIXED (xpos + box->width),
-			      CLUTTER_INT_TO_FIXED (box->height
-						    + priv->max_ascent
-						    - box->y_off),
-			      box->tx1, box->ty1, box->tx2, box->ty2);
-
-      xpos += box->advance;
+      td_number_paint_batched (num);
+      return;
     }
+#endif
+
+  /* Otherwise let Cogl draw each digit */
+  for (i = 0, v = priv->layout.vertices;
+       i < priv->layout.n_digits;
+       i++, v += 4)
+    cogl_texture_rectangle (priv->shared->tex,
+			    CLUTTER_FLOAT_TO_FIXED (v[0].x),
+			    CLUTTER_FLOAT_TO_FIXED (v[0].y),
+			    CLUTTER_FLOAT_TO_FIXED (v[2].x),
+			    CLUTTER_FLOAT_TO_FIXED (v[2].y),
+			    CLUTTER_FLOAT_TO_FIXED (v[0].s),
+			    CLUTTER_FLOAT_TO_FIXED (v[0].t),
+			    CLUTTER_FLOAT_TO_FIXED (v[2].s),
+			    CLUTTER_FLOAT_TO_FIXED (v[2].t));
+}
+
+static void
+td_number_paint (ClutterActor *self)
+{
+  TDProfilerScope scope;
+
+  td_profiler_begin (&scope, TD_PROFILER_PHASE_PAINT_NUMBER);
+  td_number_do_paint (self);
+  td_profiler_end (&scope);
 }
 
 void
 td_number_set_value (TDNumber *number, int value)
 {
   TDNumberPrivate *priv;
-  char *src, *dst;
+  int old_width, old_height;
 
   g_return_if_fail (TD_IS_NUMBER (number));
 
@@ -261,16 +268,18 @@ td_number_set_value (TDNumber *number, int value)
   if (priv->value != value)
     {
       priv->value = value;
-      g_snprintf (priv->digits, sizeof (priv->digits), "%i", value);
 
-      /* Remove any non-numeric characters */
-      dst = src = priv->digits;
-      do
-	if (*src == 0 || (*src >= '0' && *src <= '9'))
-	  *(dst++) = *src;
-      while (*(src++));
+      old_width = priv->layout.width;
+      old_height = priv->layout.height;
+
+      td_number_atlas_layout (priv->shared->atlas, value, &priv->layout);
 
-      clutter_actor_queue_relayout (CLUTTER_ACTOR (number));
+      /* Only the size affects the layout so most changes just need
+	 a redraw */
+      if (priv->layout.width != old_width || priv->layout.height != old_height)
+	clutter_actor_queue_relayout (CLUTTER_ACTOR (number));
+      else
+	clutter_actor_queue_redraw (CLUTTER_ACTOR (number));
     }
 }
 
@@ -288,10 +297,10 @@ td_number_dispose (GObject *self)
   TDNumber *num = TD_NUMBER (self);
   TDNumberPrivate *priv = num->priv;
 
-  if (priv->tex != COGL_INVALID_HANDLE)
+  if (priv->shared)
     {
-      cogl_texture_unref (priv->tex);
-      priv->tex = COGL_INVALID_HANDLE;
+      td_number_shared_unref (priv->shared);
+      priv->shared = NULL;
     }
 
   G_OBJECT_CLASS (td_number_parent_class)->dispose (self);
@@ -304,18 +313,12 @@ td_number_get_preferred_width (ClutterActor *self,
 			       ClutterUnit  *natural_width_p)
 {
   TDNumberPrivate *priv = TD_NUMBER (self)->priv;
-  int width = 0;
-  char *p;
-
-  /* Sum all of the advances of the boxes for the digits */
-  for (p = priv->digits; *p; p++)
-    width += priv->boxes[*p - '0'].advance;
 
   if (min_width_p)
-    *min_width_p = CLUTTER_UNITS_FROM_DEVICE (width);
+    *min_width_p = CLUTTER_UNITS_FROM_DEVICE (priv->layout.width);
 
   if (natural_width_p)
-    *natural_width_p = CLUTTER_UNITS_FROM_DEVICE (width);
+    *natural_width_p = CLUTTER_UNITS_FROM_DEVICE (priv->layout.width);
 }
 
 static void
@@ -325,21 +328,10 @@ td_number_get_preferred_height (ClutterActor *self,
 				ClutterUnit  *natural_height_p)
 {
   TDNumberPrivate *priv = TD_NUMBER (self)->priv;
-  int height = 0;
-  char *p;
-
-  /* Get the maximum of all of the heights */
-  for (p = priv->digits; *p; p++)
-    {
-      TDNumberBox *box = priv->boxes + *p - '0';
-      int box_height = box->height + priv->max_ascent - box->y_off;
-      if (height < box_height)
-	height = box_height;
-    }
 
   if (min_height_p)
-    *min_height_p = CLUTTER_UNITS_FROM_DEVICE (height);
+    *min_height_p = CLUTTER_UNITS_FROM_DEVICE (priv->layout.height);
 
   if (natural_height_p)
-    *natural_height_p = CLUTTER_UNITS_FROM_DEVICE (height);
+    *natural_height_p = CLUTTER_UNITS_FROM_DEVICE (priv->layout.height);
 }
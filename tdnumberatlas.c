@@ -0,0 +1,431 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <cairo.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "tdnumberatlas.h"
+#include "tdpixels.h"
+
+#define TD_NUMBER_ATLAS_SIZE 256
+#define TD_NUMBER_ATLAS_GAP  8
+
+/* The cache is only ever read back on the same machine so it is
+   written in the native byte order. The magic number reads
+   differently on the wrong byte order. Bump the version whenever the
+   way the digits are drawn changes. Changes to the font itself are
+   caught by the font key instead */
+#define TD_NUMBER_ATLAS_MAGIC   0x41444454 /* "TDDA" */
+#define TD_NUMBER_ATLAS_VERSION 2
+
+#define TD_NUMBER_ATLAS_FONT_SIZE 40.0
+
+/* Number of 32-bit words before the pixels. This is the magic,
+   version, size, font key and max ascent followed by six values for
+   each digit */
+#define TD_NUMBER_ATLAS_HEADER_SIZE (5 + 10 * 6)
+
+#define TD_NUMBER_ATLAS_ERROR (td_number_atlas_error_quark ())
+
+enum
+{
+  TD_NUMBER_ATLAS_ERROR_INVALID
+};
+
+static GQuark
+td_number_atlas_error_quark (void)
+{
+  return g_quark_from_static_string ("td-number-atlas-error-quark");
+}
+
+/* Mixes some bytes into the font key with FNV-1a */
+static guint32
+td_number_atlas_add_font_key (guint32 key, const void *data, gsize size)
+{
+  const guchar *p = data;
+  gsize i;
+
+  for (i = 0; i < size; i++)
+    key = (key ^ p[i]) * 16777619;
+
+  return key;
+}
+
+/* Mixes in the modification time of a fontconfig file or
+   directory. Missing files still change the key so that creating
+   one is noticed */
+static guint32
+td_number_atlas_add_file_key (guint32 key, const char *filename)
+{
+  struct stat buf;
+  gint64 mtime = -1;
+
+  if (filename && g_stat (filename, &buf) == 0)
+    mtime = buf.st_mtime;
+
+  return td_number_atlas_add_font_key (key, &mtime, sizeof (mtime));
+}
+
+/* Works out a value that changes whenever cairo or the fonts that
+   the digits could be drawn with change. Measuring the glyphs would
+   catch the font exactly but it needs fontconfig to load its whole
+   configuration, which is most of the cost of drawing them. Instead
+   this only looks at the version of cairo and when the fontconfig
+   configuration and caches last changed. fc-cache updates the cache
+   directories whenever fonts are installed or removed */
+static guint32
+td_number_atlas_get_font_key (void)
+{
+  guint32 key = 2166136261U;
+  int version = cairo_version ();
+  const char *config_file;
+  gchar *filename;
+
+  key = td_number_atlas_add_font_key (key, &version, sizeof (version));
+
+  if ((config_file = g_getenv ("FONTCONFIG_FILE")) == NULL)
+    config_file = "/etc/fonts/fonts.conf";
+  key = td_number_atlas_add_file_key (key, config_file);
+  key = td_number_atlas_add_file_key (key, "/etc/fonts/conf.d");
+  key = td_number_atlas_add_file_key (key, "/var/cache/fontconfig");
+
+  filename = g_build_filename (g_get_user_config_dir (), "fontconfig", NULL);
+  key = td_number_atlas_add_file_key (key, filename);
+  g_free (filename);
+
+  filename = g_build_filename (g_get_user_cache_dir (), "fontconfig", NULL);
+  key = td_number_atlas_add_file_key (key, filename);
+  g_free (filename);
+
+  return key;
+}
+
+/* Rasterizes the digits with cairo */
+TDNumberAtlas *
+td_number_atlas_build (void)
+{
+  TDNumberAtlas *atlas;
+  cairo_t *cr;
+  cairo_surface_t *surface;
+  int xpos = 0, ypos = 0;
+  int row_height = 0;
+  unsigned char *image_data;
+  int stride, y, i;
+
+  atlas = g_slice_new (TDNumberAtlas);
+  atlas->size = TD_NUMBER_ATLAS_SIZE;
+  atlas->font_key = td_number_atlas_get_font_key ();
+  atlas->max_ascent = 0;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+					TD_NUMBER_ATLAS_SIZE,
+					TD_NUMBER_ATLAS_SIZE);
+
+  cr = cairo_create (surface);
+
+  cairo_set_line_width (cr, 4.0);
+
+  cairo_set_font_size (cr, TD_NUMBER_ATLAS_FONT_SIZE);
+
+  for (i = 0; i < 10; i++)
+    {
+      char digit_str[2] = { i + '0', '\0' };
+      cairo_text_extents_t extents;
+      TDNumberGlyph *glyph = atlas->glyphs + i;
+
+      cairo_text_extents (cr, digit_str, &extents);
+
+      glyph->width = extents.width + TD_NUMBER_ATLAS_GAP;
+      glyph->height = extents.height + TD_NUMBER_ATLAS_GAP;
+      glyph->advance = extents.x_advance + 2;
+      glyph->y_off = -extents.y_bearing;
+
+      if (glyph->y_off > atlas->max_ascent)
+	atlas->max_ascent = glyph->y_off;
+
+      if (xpos + glyph->width > TD_NUMBER_ATLAS_SIZE)
+	{
+	  xpos = 0;
+	  ypos += row_height;
+	}
+
+      glyph->x = xpos;
+      glyph->y = ypos;
+
+      cairo_move_to (cr, xpos - extents.x_bearing + TD_NUMBER_ATLAS_GAP / 2,
+		     ypos - extents.y_bearing + TD_NUMBER_ATLAS_GAP / 2);
+
+      cairo_text_path (cr, digit_str);
+
+      /* Draw an outline in black */
+      cairo_set_source_rgb (cr, 0.0, 0.0, 0.0);
+      cairo_stroke_preserve (cr);
+
+      /* Fill in the shape in white */
+      cairo_set_source_rgb (cr, 0.4, 0.4, 0.8);
+      cairo_fill (cr);
+
+      if (glyph->height > row_height)
+	row_height = glyph->height;
+
+      xpos += glyph->width;
+    }
+
+  atlas->max_ascent += TD_NUMBER_ATLAS_GAP / 2;
+
+  cairo_destroy (cr);
+
+  cairo_surface_flush (surface);
+  image_data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  atlas->pixels = g_malloc (TD_NUMBER_ATLAS_SIZE * TD_NUMBER_ATLAS_SIZE * 4);
+
+  /* Convert the image from cairo format to RGBA */
+  for (y = 0; y < TD_NUMBER_ATLAS_SIZE; y++)
+    td_pixels_unpremultiply_argb32 (atlas->pixels
+				    + y * TD_NUMBER_ATLAS_SIZE * 4,
+				    image_data + y * stride,
+				    TD_NUMBER_ATLAS_SIZE);
+
+  cairo_surface_destroy (surface);
+
+  return atlas;
+}
+
+TDNumberAtlas *
+td_number_atlas_load (const char *filename, GError **error)
+{
+  TDNumberAtlas *atlas;
+  gchar *contents;
+  gsize length, pixels_size;
+  guint32 header[TD_NUMBER_ATLAS_HEADER_SIZE];
+  const guint32 *p;
+  int i;
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  if (length < sizeof (header))
+    goto invalid;
+
+  memcpy (header, contents, sizeof (header));
+
+  pixels_size = header[2] * header[2] * 4;
+
+  if (header[0] != TD_NUMBER_ATLAS_MAGIC
+      || header[1] != TD_NUMBER_ATLAS_VERSION
+      || header[2] != TD_NUMBER_ATLAS_SIZE
+      || length != sizeof (header) + pixels_size)
+    goto invalid;
+
+  atlas = g_slice_new (TDNumberAtlas);
+  atlas->size = header[2];
+  atlas->font_key = header[3];
+  atlas->max_ascent = header[4];
+
+  for (i = 0, p = header + 5; i < G_N_ELEMENTS (atlas->glyphs); i++)
+    {
+      TDNumberGlyph *glyph = atlas->glyphs + i;
+
+      glyph->x = *(p++);
+      glyph->y = *(p++);
+      glyph->width = *(p++);
+      glyph->height = *(p++);
+      glyph->advance = *(p++);
+      glyph->y_off = *(p++);
+    }
+
+  atlas->pixels = g_memdup (contents + sizeof (header), pixels_size);
+
+  g_free (contents);
+
+  return atlas;
+
+ invalid:
+  g_set_error (error, TD_NUMBER_ATLAS_ERROR, TD_NUMBER_ATLAS_ERROR_INVALID,
+	       "%s is not a valid digit cache", filename);
+  g_free (contents);
+
+  return NULL;
+}
+
+gboolean
+td_number_atlas_save (const TDNumberAtlas *atlas,
+		      const char *filename,
+		      GError **error)
+{
+  gsize pixels_size = atlas->size * atlas->size * 4;
+  guint32 header[TD_NUMBER_ATLAS_HEADER_SIZE];
+  guint32 *p = header;
+  gchar *contents;
+  gboolean ret;
+  int i;
+
+  *(p++) = TD_NUMBER_ATLAS_MAGIC;
+  *(p++) = TD_NUMBER_ATLAS_VERSION;
+  *(p++) = atlas->size;
+  *(p++) = atlas->font_key;
+  *(p++) = atlas->max_ascent;
+
+  for (i = 0; i < G_N_ELEMENTS (atlas->glyphs); i++)
+    {
+      const TDNumberGlyph *glyph = atlas->glyphs + i;
+
+      *(p++) = glyph->x;
+      *(p++) = glyph->y;
+      *(p++) = glyph->width;
+      *(p++) = glyph->height;
+      *(p++) = glyph->advance;
+      *(p++) = glyph->y_off;
+    }
+
+  contents = g_malloc (sizeof (header) + pixels_size);
+  memcpy (contents, header, sizeof (header));
+  memcpy (contents + sizeof (header), atlas->pixels, pixels_size);
+
+  ret = g_file_set_contents (filename, contents,
+			     sizeof (header) + pixels_size,
+			     error);
+
+  g_free (contents);
+
+  return ret;
+}
+
+/* Gets the atlas from the cache in the user's cache directory if
+   possible. Otherwise it is rasterized and the cache is written for
+   next time. Setting NO_ASSET_CACHE skips the cache altogether, the
+   same as for the models */
+TDNumberAtlas *
+td_number_atlas_new (void)
+{
+  TDNumberAtlas *atlas;
+  gchar *dir, *filename;
+  GError *error = NULL;
+
+  if (getenv ("NO_ASSET_CACHE"))
+    return td_number_atlas_build ();
+
+  dir = g_build_filename (g_get_user_cache_dir (), "tractordodge", NULL);
+  filename = g_build_filename (dir, "digits.cache", NULL);
+
+  atlas = td_number_atlas_load (filename, &error);
+
+  /* A cache drawn with a different font is as good as missing */
+  if (atlas && atlas->font_key != td_number_atlas_get_font_key ())
+    {
+      td_number_atlas_free (atlas);
+      atlas = NULL;
+    }
+
+  if (atlas == NULL)
+    {
+      /* A missing cache is expected the first time */
+      g_clear_error (&error);
+
+      atlas = td_number_atlas_build ();
+
+      if (g_mkdir_with_parents (dir, 0755) == -1
+	  || !td_number_atlas_save (atlas, filename, &error))
+	{
+	  if (error)
+	    {
+	      g_warning ("%s", error->message);
+	      g_error_free (error);
+	    }
+	  else
+	    g_warning ("%s: failed to create directory", dir);
+	}
+    }
+
+  g_free (filename);
+  g_free (dir);
+
+  return atlas;
+}
+
+/* Works out the digits of a number and where to draw them. Only the
+   magnitude of the value is shown */
+void
+td_number_atlas_layout (const TDNumberAtlas *atlas,
+			int value,
+			TDNumberLayout *layout)
+{
+  guint magnitude = value < 0 ? -(guint) value : (guint) value;
+  TDNumberVertex *v = layout->vertices;
+  char *p = layout->digits + TD_NUMBER_MAX_DIGITS;
+  int xpos = 0;
+
+  /* Write the digits backwards from the end of the buffer and then
+     move them to the start */
+  *p = '\0';
+  do
+    {
+      *(--p) = magnitude % 10 + '0';
+      magnitude /= 10;
+    }
+  while (magnitude);
+
+  layout->n_digits = layout->digits + TD_NUMBER_MAX_DIGITS - p;
+  memmove (layout->digits, p, layout->n_digits + 1);
+
+  layout->height = 0;
+
+  for (p = layout->digits; *p; p++)
+    {
+      const TDNumberGlyph *glyph = atlas->glyphs + *p - '0';
+      float x1 = xpos, x2 = xpos + glyph->width;
+      float y1 = atlas->max_ascent - glyph->y_off;
+      float y2 = y1 + glyph->height;
+      float s1 = glyph->x / (float) atlas->size;
+      float s2 = (glyph->x + glyph->width) / (float) atlas->size;
+      float t1 = glyph->y / (float) atlas->size;
+      float t2 = (glyph->y + glyph->height) / (float) atlas->size;
+
+      v->x = x1; v->y = y1; v->s = s1; v->t = t1; v++;
+      v->x = x2; v->y = y1; v->s = s2; v->t = t1; v++;
+      v->x = x2; v->y = y2; v->s = s2; v->t = t2; v++;
+      v->x = x1; v->y = y2; v->s = s1; v->t = t2; v++;
+
+      if (y2 > layout->height)
+	layout->height = y2;
+
+      xpos += glyph->advance;
+    }
+
+  layout->width = xpos;
+}
+
+void
+td_number_atlas_free (TDNumberAtlas *atlas)
+{
+  g_free (atlas->pixels);
+  g_slice_free (TDNumberAtlas, atlas);
+}
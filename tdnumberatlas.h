@@ -0,0 +1,97 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_NUMBER_ATLAS_H
+#define _HAVE_TD_NUMBER_ATLAS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Enough digits for any int */
+#define TD_NUMBER_MAX_DIGITS 10
+
+typedef struct _TDNumberAtlas  TDNumberAtlas;
+typedef struct _TDNumberGlyph  TDNumberGlyph;
+typedef struct _TDNumberVertex TDNumberVertex;
+typedef struct _TDNumberLayout TDNumberLayout;
+
+/* Position of a digit in the atlas in pixels */
+struct _TDNumberGlyph
+{
+  int x, y;
+  int width, height, advance, y_off;
+};
+
+/* An image containing all ten digits as unpremultiplied RGBA */
+struct _TDNumberAtlas
+{
+  /* The image is size x size pixels with a rowstride of size * 4 */
+  int size;
+  guchar *pixels;
+
+  /* Changes along with cairo and the installed fonts */
+  guint32 font_key;
+
+  int max_ascent;
+  TDNumberGlyph glyphs[10];
+};
+
+struct _TDNumberVertex
+{
+  float x, y;
+  float s, t;
+};
+
+/* The quads needed to draw a number with the atlas */
+struct _TDNumberLayout
+{
+  int n_digits;
+  char digits[TD_NUMBER_MAX_DIGITS + 1];
+
+  int width, height;
+
+  /* The four corners of a quad for each digit, clockwise from the
+     top left */
+  TDNumberVertex vertices[TD_NUMBER_MAX_DIGITS * 4];
+};
+
+TDNumberAtlas *td_number_atlas_new (void);
+TDNumberAtlas *td_number_atlas_build (void);
+
+TDNumberAtlas *td_number_atlas_load (const char *filename, GError **error);
+gboolean td_number_atlas_save (const TDNumberAtlas *atlas,
+			       const char *filename,
+			       GError **error);
+
+void td_number_atlas_free (TDNumberAtlas *atlas);
+
+void td_number_atlas_layout (const TDNumberAtlas *atlas,
+			     int value,
+			     TDNumberLayout *layout);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_NUMBER_ATLAS_H */
@@ -0,0 +1,333 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "tdpixels.h"
+
+/* Conversions between the pixel formats used by cairo, Cogl and the
+   stage read back. The SIMD versions are picked at runtime depending
+   on what the CPU supports */
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define TD_PIXELS_HAVE_X86
+#include <immintrin.h>
+#endif
+
+typedef void (* TDPixelsUnpremultiplyFunc) (guint8 *dst,
+					    const guint8 *src,
+					    int n_pixels);
+typedef void (* TDPixelsSetOpaqueFunc) (guint8 *pixels, int n_pixels);
+
+static TDPixelsImpl td_pixels_impl;
+static TDPixelsUnpremultiplyFunc td_pixels_unpremultiply_func;
+static TDPixelsSetOpaqueFunc td_pixels_set_opaque_func;
+
+/* Converts cairo's premultiplied native-endian ARGB32 to
+   unpremultiplied RGBA bytes */
+static void
+td_pixels_unpremultiply_scalar (guint8 *dst, const guint8 *src, int n_pixels)
+{
+  const guint32 *s = (const guint32 *) src;
+
+  for (; n_pixels > 0; n_pixels--, dst += 4)
+    {
+      guint32 v = *(s++);
+      guint8 alpha = v >> 24;
+
+      if (alpha == 0)
+	memset (dst, 0, sizeof (guint32));
+      else
+	{
+	  dst[0] = ((v >> 16) & 0xff) * 255 / alpha;
+	  dst[1] = ((v >> 8) & 0xff) * 255 / alpha;
+	  dst[2] = (v & 0xff) * 255 / alpha;
+	  dst[3] = alpha;
+	}
+    }
+}
+
+static void
+td_pixels_set_opaque_scalar (guint8 *pixels, int n_pixels)
+{
+  for (pixels += 3; n_pixels > 0; n_pixels--, pixels += 4)
+    *pixels = 0xff;
+}
+
+#ifdef TD_PIXELS_HAVE_X86
+
+/* The SIMD versions divide in single precision floats. The dividend
+   is an integer below 2^16 and the quotient is at most 255 so the
+   rounding error is always less than the distance to the next
+   integer and truncating gives the same result as the integer
+   division */
+
+__attribute__ ((target ("sse2")))
+static void
+td_pixels_unpremultiply_sse2 (guint8 *dst, const guint8 *src, int n_pixels)
+{
+  const __m128i mask = _mm_set1_epi32 (0xff);
+  const __m128 max = _mm_set1_ps (255.0f);
+
+  for (; n_pixels >= 4; n_pixels -= 4, src += 16, dst += 16)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) src);
+      __m128i a = _mm_srli_epi32 (v, 24);
+      __m128 af = _mm_cvtepi32_ps (a);
+      __m128i r, g, b, out;
+
+      r = _mm_and_si128 (_mm_srli_epi32 (v, 16), mask);
+      g = _mm_and_si128 (_mm_srli_epi32 (v, 8), mask);
+      b = _mm_and_si128 (v, mask);
+
+      r = _mm_cvttps_epi32 (_mm_div_ps (_mm_mul_ps (_mm_cvtepi32_ps (r), max),
+					af));
+      g = _mm_cvttps_epi32 (_mm_div_ps (_mm_mul_ps (_mm_cvtepi32_ps (g), max),
+					af));
+      b = _mm_cvttps_epi32 (_mm_div_ps (_mm_mul_ps (_mm_cvtepi32_ps (b), max),
+					af));
+
+      out = _mm_or_si128 (_mm_or_si128 (_mm_and_si128 (r, mask),
+					_mm_slli_epi32 (_mm_and_si128 (g, mask),
+							8)),
+			  _mm_or_si128 (_mm_slli_epi32 (_mm_and_si128 (b, mask),
+							16),
+					_mm_slli_epi32 (a, 24)));
+
+      /* Fully transparent pixels divided by zero so clear them */
+      out = _mm_andnot_si128 (_mm_cmpeq_epi32 (a, _mm_setzero_si128 ()), out);
+
+      _mm_storeu_si128 ((__m128i *) dst, out);
+    }
+
+  td_pixels_unpremultiply_scalar (dst, src, n_pixels);
+}
+
+__attribute__ ((target ("sse2")))
+static void
+td_pixels_set_opaque_sse2 (guint8 *pixels, int n_pixels)
+{
+  const __m128i alpha = _mm_set1_epi32 (0xff000000);
+
+  for (; n_pixels >= 4; n_pixels -= 4, pixels += 16)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) pixels);
+
+      _mm_storeu_si128 ((__m128i *) pixels, _mm_or_si128 (v, alpha));
+    }
+
+  td_pixels_set_opaque_scalar (pixels, n_pixels);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+td_pixels_unpremultiply_avx2 (guint8 *dst, const guint8 *src, int n_pixels)
+{
+  const __m256i mask = _mm256_set1_epi32 (0xff);
+  const __m256 max = _mm256_set1_ps (255.0f);
+
+  for (; n_pixels >= 8; n_pixels -= 8, src += 32, dst += 32)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) src);
+      __m256i a = _mm256_srli_epi32 (v, 24);
+      __m256 af = _mm256_cvtepi32_ps (a);
+      __m256i r, g, b, out;
+
+      r = _mm256_and_si256 (_mm256_srli_epi32 (v, 16), mask);
+      g = _mm256_and_si256 (_mm256_srli_epi32 (v, 8), mask);
+      b = _mm256_and_si256 (v, mask);
+
+      r = _mm256_cvttps_epi32 (_mm256_div_ps (_mm256_mul_ps
+					      (_mm256_cvtepi32_ps (r), max),
+					      af));
+      g = _mm256_cvttps_epi32 (_mm256_div_ps (_mm256_mul_ps
+					      (_mm256_cvtepi32_ps (g), max),
+					      af));
+      b = _mm256_cvttps_epi32 (_mm256_div_ps (_mm256_mul_ps
+					      (_mm256_cvtepi32_ps (b), max),
+					      af));
+
+      out = _mm256_or_si256
+	(_mm256_or_si256 (_mm256_and_si256 (r, mask),
+			  _mm256_slli_epi32 (_mm256_and_si256 (g, mask), 8)),
+	 _mm256_or_si256 (_mm256_slli_epi32 (_mm256_and_si256 (b, mask), 16),
+			  _mm256_slli_epi32 (a, 24)));
+
+      out = _mm256_andnot_si256 (_mm256_cmpeq_epi32 (a,
+						     _mm256_setzero_si256 ()),
+				 out);
+
+      _mm256_storeu_si256 ((__m256i *) dst, out);
+    }
+
+  /* Don't leave the upper halves dirty for the SSE2 code */
+  _mm256_zeroupper ();
+
+  td_pixels_unpremultiply_sse2 (dst, src, n_pixels);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+td_pixels_set_opaque_avx2 (guint8 *pixels, int n_pixels)
+{
+  const __m256i alpha = _mm256_set1_epi32 (0xff000000);
+
+  for (; n_pixels >= 8; n_pixels -= 8, pixels += 32)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) pixels);
+
+      _mm256_storeu_si256 ((__m256i *) pixels, _mm256_or_si256 (v, alpha));
+    }
+
+  /* Don't leave the upper halves dirty for the SSE2 code */
+  _mm256_zeroupper ();
+
+  td_pixels_set_opaque_sse2 (pixels, n_pixels);
+}
+
+#endif /* TD_PIXELS_HAVE_X86 */
+
+static gboolean
+td_pixels_impl_supported (TDPixelsImpl impl)
+{
+  switch (impl)
+    {
+    case TD_PIXELS_IMPL_SCALAR:
+      return TRUE;
+
+#ifdef TD_PIXELS_HAVE_X86
+    case TD_PIXELS_IMPL_SSE2:
+      return __builtin_cpu_supports ("sse2");
+
+    case TD_PIXELS_IMPL_AVX2:
+      return __builtin_cpu_supports ("avx2");
+#endif
+
+    default:
+      return FALSE;
+    }
+}
+
+static void
+td_pixels_use_impl (TDPixelsImpl impl)
+{
+  td_pixels_impl = impl;
+
+  switch (impl)
+    {
+#ifdef TD_PIXELS_HAVE_X86
+    case TD_PIXELS_IMPL_AVX2:
+      td_pixels_unpremultiply_func = td_pixels_unpremultiply_avx2;
+      td_pixels_set_opaque_func = td_pixels_set_opaque_avx2;
+      break;
+
+    case TD_PIXELS_IMPL_SSE2:
+      td_pixels_unpremultiply_func = td_pixels_unpremultiply_sse2;
+      td_pixels_set_opaque_func = td_pixels_set_opaque_sse2;
+      break;
+#endif
+
+    default:
+      td_pixels_unpremultiply_func = td_pixels_unpremultiply_scalar;
+      td_pixels_set_opaque_func = td_pixels_set_opaque_scalar;
+      break;
+    }
+}
+
+static void
+td_pixels_init (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      TDPixelsImpl impl = TD_PIXELS_IMPL_AVX2;
+
+      /* Use the best version the CPU supports */
+      while (!td_pixels_impl_supported (impl))
+	impl--;
+
+      td_pixels_use_impl (impl);
+
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
+void
+td_pixels_unpremultiply_argb32 (guint8 *dst, const guint8 *src, int n_pixels)
+{
+  td_pixels_init ();
+
+  td_pixels_unpremultiply_func (dst, src, n_pixels);
+}
+
+/* Sets the alpha component of each pixel of RGBA bytes to 0xff */
+void
+td_pixels_set_opaque_rgba (guint8 *pixels, int n_pixels)
+{
+  td_pixels_init ();
+
+  td_pixels_set_opaque_func (pixels, n_pixels);
+}
+
+/* Overrides the implementation picked at startup. Returns FALSE if
+   the CPU doesn't support it */
+gboolean
+td_pixels_set_impl (TDPixelsImpl impl)
+{
+  td_pixels_init ();
+
+  if (!td_pixels_impl_supported (impl))
+    return FALSE;
+
+  td_pixels_use_impl (impl);
+
+  return TRUE;
+}
+
+TDPixelsImpl
+td_pixels_get_impl (void)
+{
+  td_pixels_init ();
+
+  return td_pixels_impl;
+}
+
+const char *
+td_pixels_get_impl_name (TDPixelsImpl impl)
+{
+  switch (impl)
+    {
+    case TD_PIXELS_IMPL_SCALAR:
+      return "scalar";
+    case TD_PIXELS_IMPL_SSE2:
+      return "sse2";
+    case TD_PIXELS_IMPL_AVX2:
+      return "avx2";
+    }
+
+  return "unknown";
+}
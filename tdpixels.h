@@ -0,0 +1,51 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_PIXELS_H
+#define _HAVE_TD_PIXELS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  TD_PIXELS_IMPL_SCALAR,
+  TD_PIXELS_IMPL_SSE2,
+  TD_PIXELS_IMPL_AVX2
+} TDPixelsImpl;
+
+void td_pixels_unpremultiply_argb32 (guint8 *dst,
+				     const guint8 *src,
+				     int n_pixels);
+void td_pixels_set_opaque_rgba (guint8 *pixels, int n_pixels);
+
+gboolean td_pixels_set_impl (TDPixelsImpl impl);
+TDPixelsImpl td_pixels_get_impl (void);
+const char *td_pixels_get_impl_name (TDPixelsImpl impl);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_PIXELS_H */
@@ -0,0 +1,154 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Measures the throughput of each implementation of the pixel
+   conversions for a range of image sizes */
+
+#include <glib.h>
+#include <string.h>
+
+#include "tdpixels.h"
+
+/* Minimum time to spend on each measurement */
+#define MIN_SECONDS 0.2
+
+typedef struct _Size Size;
+
+struct _Size
+{
+  int width, height;
+};
+
+static const Size sizes[] =
+  {
+    { 256, 256 },
+    { 512, 512 },
+    { 1024, 1024 },
+    { 1920, 1080 }
+  };
+
+static void
+fill_premultiplied (guint8 *pixels, int n_pixels)
+{
+  GRand *rand = g_rand_new_with_seed (42);
+  guint32 *p = (guint32 *) pixels;
+  int i;
+
+  for (i = 0; i < n_pixels; i++)
+    {
+      guint32 alpha = g_rand_int_range (rand, 0, 256);
+      guint32 r = g_rand_int_range (rand, 0, alpha + 1);
+      guint32 g = g_rand_int_range (rand, 0, alpha + 1);
+      guint32 b = g_rand_int_range (rand, 0, alpha + 1);
+
+      *(p++) = (alpha << 24) | (r << 16) | (g << 8) | b;
+    }
+
+  g_rand_free (rand);
+}
+
+static gdouble
+measure_unpremultiply (guint8 *dst, const guint8 *src, int n_pixels)
+{
+  GTimer *timer = g_timer_new ();
+  gdouble elapsed;
+  int n_runs = 0;
+
+  do
+    {
+      td_pixels_unpremultiply_argb32 (dst, src, n_pixels);
+      n_runs++;
+    }
+  while ((elapsed = g_timer_elapsed (timer, NULL)) < MIN_SECONDS);
+
+  g_timer_destroy (timer);
+
+  return n_pixels * 4.0 * n_runs / elapsed / (1024.0 * 1024.0);
+}
+
+static gdouble
+measure_set_opaque (guint8 *pixels, int n_pixels)
+{
+  GTimer *timer = g_timer_new ();
+  gdouble elapsed;
+  int n_runs = 0;
+
+  do
+    {
+      td_pixels_set_opaque_rgba (pixels, n_pixels);
+      n_runs++;
+    }
+  while ((elapsed = g_timer_elapsed (timer, NULL)) < MIN_SECONDS);
+
+  g_timer_destroy (timer);
+
+  return n_pixels * 4.0 * n_runs / elapsed / (1024.0 * 1024.0);
+}
+
+int
+main (int argc, char **argv)
+{
+  TDPixelsImpl impl;
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      int n_pixels = sizes[i].width * sizes[i].height;
+      guint8 *src = g_malloc (n_pixels * 4);
+      guint8 *expected = g_malloc (n_pixels * 4);
+      guint8 *dst = g_malloc (n_pixels * 4);
+
+      fill_premultiplied (src, n_pixels);
+
+      td_pixels_set_impl (TD_PIXELS_IMPL_SCALAR);
+      td_pixels_unpremultiply_argb32 (expected, src, n_pixels);
+
+      for (impl = TD_PIXELS_IMPL_SCALAR; impl <= TD_PIXELS_IMPL_AVX2; impl++)
+	{
+	  const char *name = td_pixels_get_impl_name (impl);
+
+	  if (!td_pixels_set_impl (impl))
+	    continue;
+
+	  g_print ("unpremultiply %-6s %4ix%-4i %8.1f MB/s\n",
+		   name, sizes[i].width, sizes[i].height,
+		   measure_unpremultiply (dst, src, n_pixels));
+
+	  if (memcmp (dst, expected, n_pixels * 4))
+	    g_print ("unpremultiply %-6s doesn't match scalar version!\n",
+		     name);
+
+	  g_print ("set-opaque    %-6s %4ix%-4i %8.1f MB/s\n",
+		   name, sizes[i].width, sizes[i].height,
+		   measure_set_opaque (dst, n_pixels));
+	}
+
+      g_free (dst);
+      g_free (expected);
+      g_free (src);
+    }
+
+  return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Times the main phases of a frame with scoped timers. Every scope
+   that ends is stored in a ring buffer so that the last few seconds
+   can be summarised for the overlay or written out in the Chrome
+   trace_event format to look at in chrome://tracing. Everything runs
+   on the main thread so there is no locking. When the profiler is
+   disabled the scopes only cost a test of a flag */
+
+#include <glib.h>
+
+#include "tdprofiler.h"
+
+/* Enough for several seconds of frames at 60 per second */
+#define TD_PROFILER_N_EVENTS 16384
+
+typedef struct _TDProfilerEvent TDProfilerEvent;
+
+struct _TDProfilerEvent
+{
+  gint64 start;
+  gint32 duration;
+  guint8 phase;
+};
+
+static const char * const td_profiler_phase_names[] =
+  {
+    "new-frame",
+    "spawn tractor",
+    "layout",
+    "paint road",
+    "paint tractors",
+    "paint car",
+    "paint number",
+    "capture frame"
+  };
+
+static gboolean td_profiler_enabled = FALSE;
+static GTimer *td_profiler_timer = NULL;
+
+/* The next event to write. Once n_events reaches the size of the
+   buffer this is also the oldest event */
+static TDProfilerEvent td_profiler_events[TD_PROFILER_N_EVENTS];
+static guint td_profiler_next_event = 0;
+static guint td_profiler_n_events = 0;
+
+static gint64
+td_profiler_now (void)
+{
+  return g_timer_elapsed (td_profiler_timer, NULL) * 1e6;
+}
+
+void
+td_profiler_set_enabled (gboolean enabled)
+{
+  if (enabled && td_profiler_timer == NULL)
+    td_profiler_timer = g_timer_new ();
+
+  td_profiler_enabled = enabled;
+}
+
+gboolean
+td_profiler_get_enabled (void)
+{
+  return td_profiler_enabled;
+}
+
+void
+td_profiler_begin (TDProfilerScope *scope, TDProfilerPhase phase)
+{
+  scope->phase = phase;
+  scope->start = td_profiler_enabled ? td_profiler_now () : -1;
+}
+
+void
+td_profiler_end (TDProfilerScope *scope)
+{
+  TDProfilerEvent *event;
+
+  if (scope->start < 0 || !td_profiler_enabled)
+    return;
+
+  event = td_profiler_events + td_profiler_next_event;
+  event->start = scope->start;
+  event->duration = td_profiler_now () - scope->start;
+  event->phase = scope->phase;
+
+  td_profiler_next_event = (td_profiler_next_event + 1) % TD_PROFILER_N_EVENTS;
+  if (td_profiler_n_events < TD_PROFILER_N_EVENTS)
+    td_profiler_n_events++;
+}
+
+const char *
+td_profiler_get_phase_name (TDProfilerPhase phase)
+{
+  g_return_val_if_fail (phase < TD_PROFILER_N_PHASES, NULL);
+
+  return td_profiler_phase_names[phase];
+}
+
+/* Gets the event that is age events older than the newest one */
+static const TDProfilerEvent *
+td_profiler_get_event (guint age)
+{
+  return (td_profiler_events
+	  + (td_profiler_next_event + TD_PROFILER_N_EVENTS - 1 - age)
+	  % TD_PROFILER_N_EVENTS);
+}
+
+/* Fills in the average time of each phase and how often it happened
+   over the last window_usecs. Both arrays have TD_PROFILER_N_PHASES
+   entries */
+void
+td_profiler_get_averages (gint64 window_usecs,
+			  double *msecs_per_call,
+			  double *calls_per_sec)
+{
+  gint64 totals[TD_PROFILER_N_PHASES] = { 0 };
+  guint counts[TD_PROFILER_N_PHASES] = { 0 };
+  gint64 since;
+  guint i;
+
+  if (td_profiler_timer == NULL)
+    since = 0;
+  else
+    since = td_profiler_now () - window_usecs;
+
+  /* The events are roughly in time order so stop at the first one
+     that is too old */
+  for (i = 0; i < td_profiler_n_events; i++)
+    {
+      const TDProfilerEvent *event = td_profiler_get_event (i);
+
+      if (event->start < since)
+	break;
+
+      totals[event->phase] += event->duration;
+      counts[event->phase]++;
+    }
+
+  for (i = 0; i < TD_PROFILER_N_PHASES; i++)
+    {
+      msecs_per_call[i] = counts[i] ? totals[i] / 1000.0 / counts[i] : 0.0;
+      calls_per_sec[i] = counts[i] * 1e6 / window_usecs;
+    }
+}
+
+/* Writes every event in the buffer as a complete event in the Chrome
+   trace_event JSON format */
+gboolean
+td_profiler_write_trace (const char *filename, GError **error)
+{
+  GString *str = g_string_sized_new (td_profiler_n_events * 80 + 64);
+  gboolean ret;
+  guint i;
+
+  g_string_append (str, "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+
+  /* Oldest first */
+  for (i = td_profiler_n_events; i > 0; i--)
+    {
+      const TDProfilerEvent *event = td_profiler_get_event (i - 1);
+
+      g_string_append_printf (str,
+			      "%s\n  { \"name\": \"%s\", \"ph\": \"X\", "
+			      "\"ts\": %" G_GINT64_FORMAT ", \"dur\": %i, "
+			      "\"pid\": 1, \"tid\": 1 }",
+			      i < td_profiler_n_events ? "," : "",
+			      td_profiler_phase_names[event->phase],
+			      event->start, event->duration);
+    }
+
+  g_string_append (str, "\n] }\n");
+
+  ret = g_file_set_contents (filename, str->str, str->len, error);
+
+  g_string_free (str, TRUE);
+
+  return ret;
+}
@@ -0,0 +1,74 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_PROFILER_H
+#define _HAVE_TD_PROFILER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  TD_PROFILER_PHASE_NEW_FRAME,
+  TD_PROFILER_PHASE_SPAWN,
+  TD_PROFILER_PHASE_LAYOUT,
+  TD_PROFILER_PHASE_PAINT_ROAD,
+  TD_PROFILER_PHASE_PAINT_TRACTORS,
+  /* The car, timed around its paint signal */
+  TD_PROFILER_PHASE_PAINT_CAR,
+  TD_PROFILER_PHASE_PAINT_NUMBER,
+  /* Reading the stage back for RECORD */
+  TD_PROFILER_PHASE_CAPTURE,
+
+  TD_PROFILER_N_PHASES
+} TDProfilerPhase;
+
+typedef struct _TDProfilerScope TDProfilerScope;
+
+/* Lives on the stack between td_profiler_begin and td_profiler_end */
+struct _TDProfilerScope
+{
+  TDProfilerPhase phase;
+  /* Microseconds since the profiler was enabled or -1 if it wasn't */
+  gint64 start;
+};
+
+void td_profiler_set_enabled (gboolean enabled);
+gboolean td_profiler_get_enabled (void);
+
+void td_profiler_begin (TDProfilerScope *scope, TDProfilerPhase phase);
+void td_profiler_end (TDProfilerScope *scope);
+
+const char *td_profiler_get_phase_name (TDProfilerPhase phase);
+void td_profiler_get_averages (gint64 window_usecs,
+			       double *msecs_per_call,
+			       double *calls_per_sec);
+
+gboolean td_profiler_write_trace (const char *filename, GError **error);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_PROFILER_H */
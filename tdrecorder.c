@@ -0,0 +1,265 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "tdrecorder.h"
+#include "tdpixels.h"
+
+/* Records frames to a file from a separate thread. The frames are
+   queued in a ring buffer and if the writer can't keep up then new
+   frames are dropped rather than making the main loop wait */
+
+/* Maximum number of frames waiting to be written */
+#define TD_RECORDER_RING_SIZE 16
+
+typedef enum
+{
+  TD_RECORDER_FORMAT_Y4M,
+  TD_RECORDER_FORMAT_RGBA
+} TDRecorderFormat;
+
+struct _TDRecorder
+{
+  FILE *file;
+  char *filename;
+  TDRecorderFormat format;
+  int width, height;
+
+  GThread *thread;
+  GMutex *mutex;
+  GCond *cond;
+
+  /* Everything below is protected by the mutex */
+  guchar *ring[TD_RECORDER_RING_SIZE];
+  int ring_start, ring_length;
+  gboolean quit;
+
+  guint n_written, n_dropped;
+};
+
+static void
+td_recorder_write_y4m (TDRecorder *recorder, guchar *pixels, guchar *planes)
+{
+  int n_pixels = recorder->width * recorder->height;
+  guchar *y = planes, *u = y + n_pixels, *v = u + n_pixels;
+  const guchar *p = pixels;
+  int i;
+
+  /* Convert to planar 4:4:4 YCbCr with the BT.601 coefficients */
+  for (i = 0; i < n_pixels; i++, p += 4)
+    {
+      int r = p[0], g = p[1], b = p[2];
+
+      *(y++) = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+      *(u++) = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+      *(v++) = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+    }
+
+  fputs ("FRAME\n", recorder->file);
+  fwrite (planes, n_pixels, 3, recorder->file);
+}
+
+static void
+td_recorder_write_rgba (TDRecorder *recorder, guchar *pixels)
+{
+  int n_pixels = recorder->width * recorder->height;
+
+  /* The stage has no meaningful alpha so make it opaque */
+  td_pixels_set_opaque_rgba (pixels, n_pixels);
+
+  fwrite (pixels, n_pixels, 4, recorder->file);
+}
+
+static gpointer
+td_recorder_thread_func (gpointer data)
+{
+  TDRecorder *recorder = data;
+  guchar *planes = NULL;
+
+  if (recorder->format == TD_RECORDER_FORMAT_Y4M)
+    planes = g_malloc (recorder->width * recorder->height * 3);
+
+  g_mutex_lock (recorder->mutex);
+
+  for (;;)
+    {
+      guchar *pixels;
+
+      while (recorder->ring_length == 0 && !recorder->quit)
+	g_cond_wait (recorder->cond, recorder->mutex);
+
+      /* Write out any remaining frames before quitting */
+      if (recorder->ring_length == 0)
+	break;
+
+      pixels = recorder->ring[recorder->ring_start];
+      recorder->ring_start = ((recorder->ring_start + 1)
+			      % TD_RECORDER_RING_SIZE);
+      recorder->ring_length--;
+
+      g_mutex_unlock (recorder->mutex);
+
+      if (recorder->format == TD_RECORDER_FORMAT_Y4M)
+	td_recorder_write_y4m (recorder, pixels, planes);
+      else
+	td_recorder_write_rgba (recorder, pixels);
+
+      g_free (pixels);
+
+      g_mutex_lock (recorder->mutex);
+
+      recorder->n_written++;
+    }
+
+  g_mutex_unlock (recorder->mutex);
+
+  g_free (planes);
+
+  return NULL;
+}
+
+/* Starts recording to filename. If the name ends in .y4m then the
+   frames are written as a YUV4MPEG2 stream, otherwise they are
+   written one after the other as raw RGBA */
+TDRecorder *
+td_recorder_new (const char *filename,
+		 int width, int height,
+		 int fps,
+		 GError **error)
+{
+  TDRecorder *recorder;
+  FILE *file;
+
+  if ((file = g_fopen (filename, "wb")) == NULL)
+    {
+      int errnum = errno;
+
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errnum),
+		   "%s: %s", filename, g_strerror (errnum));
+
+      return NULL;
+    }
+
+  recorder = g_slice_new0 (TDRecorder);
+  recorder->file = file;
+  recorder->filename = g_strdup (filename);
+  recorder->width = width;
+  recorder->height = height;
+
+  if (g_str_has_suffix (filename, ".y4m"))
+    {
+      recorder->format = TD_RECORDER_FORMAT_Y4M;
+      fprintf (file, "YUV4MPEG2 W%i H%i F%i:1 Ip A1:1 C444\n",
+	       width, height, fps);
+    }
+  else
+    recorder->format = TD_RECORDER_FORMAT_RGBA;
+
+  recorder->mutex = g_mutex_new ();
+  recorder->cond = g_cond_new ();
+
+  recorder->thread = g_thread_create (td_recorder_thread_func, recorder,
+				      TRUE, error);
+
+  if (recorder->thread == NULL)
+    {
+      /* Don't leave a file with only the header in it */
+      fclose (file);
+      g_unlink (filename);
+
+      g_mutex_free (recorder->mutex);
+      g_cond_free (recorder->cond);
+      g_free (recorder->filename);
+      g_slice_free (TDRecorder, recorder);
+
+      return NULL;
+    }
+
+  return recorder;
+}
+
+/* Queues a frame of width * height RGBA pixels to be written. This
+   takes ownership of the pixels which must have been allocated with
+   g_malloc */
+void
+td_recorder_add_frame (TDRecorder *recorder, guchar *pixels)
+{
+  g_mutex_lock (recorder->mutex);
+
+  if (recorder->ring_length >= TD_RECORDER_RING_SIZE)
+    {
+      /* The writer is behind so drop the frame */
+      recorder->n_dropped++;
+      g_free (pixels);
+    }
+  else
+    {
+      recorder->ring[(recorder->ring_start + recorder->ring_length)
+		     % TD_RECORDER_RING_SIZE] = pixels;
+      recorder->ring_length++;
+      g_cond_signal (recorder->cond);
+    }
+
+  g_mutex_unlock (recorder->mutex);
+}
+
+int
+td_recorder_get_width (TDRecorder *recorder)
+{
+  return recorder->width;
+}
+
+int
+td_recorder_get_height (TDRecorder *recorder)
+{
+  return recorder->height;
+}
+
+/* Waits for the queued frames to be written and closes the file */
+void
+td_recorder_free (TDRecorder *recorder)
+{
+  g_mutex_lock (recorder->mutex);
+  recorder->quit = TRUE;
+  g_cond_signal (recorder->cond);
+  g_mutex_unlock (recorder->mutex);
+
+  g_thread_join (recorder->thread);
+
+  g_print ("%s: %u frames written, %u dropped\n",
+	   recorder->filename, recorder->n_written, recorder->n_dropped);
+
+  fclose (recorder->file);
+
+  g_mutex_free (recorder->mutex);
+  g_cond_free (recorder->cond);
+  g_free (recorder->filename);
+
+  g_slice_free (TDRecorder, recorder);
+}
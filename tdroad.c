@@ -0,0 +1,201 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <clutter/clutter-actor.h>
+#include <cogl/cogl.h>
+
+#include "tdroad.h"
+#include "tdprofiler.h"
+
+#define TD_ROAD_GET_PRIVATE(obj) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj), TD_TYPE_ROAD, TDRoadPrivate))
+
+G_DEFINE_TYPE (TDRoad, td_road, CLUTTER_TYPE_ACTOR)
+
+static void td_road_paint (ClutterActor *self);
+static void td_road_dispose (GObject *self);
+
+#define TD_ROAD_LINE_WIDTH  15
+#define TD_ROAD_LINE_HEIGHT 30
+#define TD_ROAD_LINE_GAP    20
+/* Distance from the top of one line to the top of the next */
+#define TD_ROAD_LINE_PERIOD (TD_ROAD_LINE_HEIGHT + TD_ROAD_LINE_GAP)
+
+struct _TDRoadPrivate
+{
+  /* A single line followed by the gap. This gets repeated down the
+     whole length of the road in one textured rectangle */
+  CoglHandle line_tex;
+
+  float progress;
+};
+
+static const ClutterColor td_road_color = { 0x60, 0x60, 0x60, 0xff };
+static const ClutterColor td_road_line_color = { 0xe0, 0xe0, 0x00, 0xff };
+
+static void
+td_road_class_init (TDRoadClass *klass)
+{
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  actor_class->paint = td_road_paint;
+
+  object_class->dispose = td_road_dispose;
+
+  g_type_class_add_private (klass, sizeof (TDRoadPrivate));
+}
+
+static void
+td_road_init (TDRoad *self)
+{
+  TDRoadPrivate *priv;
+  guchar *image_data, *p;
+  int i;
+
+  self->priv = priv = TD_ROAD_GET_PRIVATE (self);
+
+  priv->progress = 0.0f;
+
+  p = image_data = g_malloc0 (TD_ROAD_LINE_WIDTH * TD_ROAD_LINE_PERIOD * 4);
+
+  /* Fill in the line and leave the gap transparent */
+  for (i = 0; i < TD_ROAD_LINE_WIDTH * TD_ROAD_LINE_HEIGHT; i++)
+    {
+      *(p++) = td_road_line_color.red;
+      *(p++) = td_road_line_color.green;
+      *(p++) = td_road_line_color.blue;
+      *(p++) = td_road_line_color.alpha;
+    }
+
+  priv->line_tex = cogl_texture_new_from_data (TD_ROAD_LINE_WIDTH,
+					       TD_ROAD_LINE_PERIOD,
+					       -1,
+					       FALSE,
+					       COGL_PIXEL_FORMAT_RGBA_8888,
+					       COGL_PIXEL_FORMAT_RGBA_8888,
+					       TD_ROAD_LINE_WIDTH * 4,
+					       image_data);
+
+  g_free (image_data);
+}
+
+ClutterActor *
+td_road_new (void)
+{
+  return g_object_new (TD_TYPE_ROAD, NULL);
+}
+
+static void
+td_road_do_paint (ClutterActor *self)
+{
+  TDRoadPrivate *priv = TD_ROAD (self)->priv;
+  guint8 opacity = clutter_actor_get_paint_opacity (self);
+  ClutterColor color;
+  gint x1, y1, x2, y2;
+  int width, height, line_x, n_lines;
+  float scroll;
+
+  clutter_actor_get_allocation_coords (self, &x1, &y1, &x2, &y2);
+  width = x2 - x1;
+  height = y2 - y1;
+
+  color = td_road_color;
+  color.alpha = color.alpha * opacity / 255;
+  cogl_color (&color);
+  cogl_rectangle (0, 0, width, height);
+
+  if (priv->line_tex == COGL_INVALID_HANDLE)
+    return;
+
+  /* Scroll a whole number of lines plus one over a cycle so that the
+     animation loops seamlessly. The lines move down the road so the
+     texture coordinates move up */
+  n_lines = (height + TD_ROAD_LINE_PERIOD - 1) / TD_ROAD_LINE_PERIOD + 1;
+  scroll = -priv->progress * n_lines;
+
+  line_x = width / 2 - TD_ROAD_LINE_WIDTH / 2;
+
+  color.red = color.green = color.blue = 0xff;
+  color.alpha = opacity;
+  cogl_color (&color);
+
+  cogl_texture_rectangle (priv->line_tex,
+			  CLUTTER_INT_TO_FIXED (line_x),
+			  0,
+			  CLUTTER_INT_TO_FIXED (line_x + TD_ROAD_LINE_WIDTH),
+			  CLUTTER_INT_TO_FIXED (height),
+			  0,
+			  CLUTTER_FLOAT_TO_FIXED (scroll),
+			  CFX_ONE,
+			  CLUTTER_FLOAT_TO_FIXED (scroll + height
+						  / (float) TD_ROAD_LINE_PERIOD));
+}
+
+static void
+td_road_paint (ClutterActor *self)
+{
+  TDProfilerScope scope;
+
+  td_profiler_begin (&scope, TD_PROFILER_PHASE_PAINT_ROAD);
+  td_road_do_paint (self);
+  td_profiler_end (&scope);
+}
+
+/* Sets how far through the scrolling cycle the lines are, from 0 to
+   1. Over one cycle the lines move down by about the length of the
+   road */
+void
+td_road_set_progress (TDRoad *road, float progress)
+{
+  g_return_if_fail (TD_IS_ROAD (road));
+
+  road->priv->progress = progress;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (road));
+}
+
+float
+td_road_get_progress (TDRoad *road)
+{
+  g_return_val_if_fail (TD_IS_ROAD (road), 0.0f);
+
+  return road->priv->progress;
+}
+
+static void
+td_road_dispose (GObject *self)
+{
+  TDRoad *road = TD_ROAD (self);
+  TDRoadPrivate *priv = road->priv;
+
+  if (priv->line_tex != COGL_INVALID_HANDLE)
+    {
+      cogl_texture_unref (priv->line_tex);
+      priv->line_tex = COGL_INVALID_HANDLE;
+    }
+
+  G_OBJECT_CLASS (td_road_parent_class)->dispose (self);
+}
@@ -0,0 +1,315 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Loads a scenario describing exactly when each tractor appears
+   instead of the usual random ramp. The file is a GKeyFile with a
+   [Scenario] group giving its Name, how many Lanes the road is split
+   into and whether the car is Invincible so that the road can fill
+   up. Every other group is a wave with these keys:
+
+     Time     - seconds after the start of the game (required)
+     Count    - number of tractors in the wave (required)
+     Lanes    - list of lanes to use in turn, default all of them
+     Skin     - skin of every tractor, default random
+     Speed    - how many times faster than normal, default 1
+     Interval - seconds between each tractor, default 0
+
+   The waves are flattened into one list of tractors sorted by time
+   when the file is loaded */
+
+#include <glib.h>
+#include <string.h>
+
+#include "tdscenario.h"
+
+#define TD_SCENARIO_GROUP "Scenario"
+
+/* Stop a mistyped count from eating all of the memory */
+#define TD_SCENARIO_MAX_SPAWNS 1000000
+
+struct _TDScenario
+{
+  char *name;
+  gboolean invincible;
+
+  guint n_spawns;
+  TDScenarioSpawn *spawns;
+};
+
+/* Wraps a spawn with its place in the file so that the sort keeps the
+   order of tractors that appear at the same time */
+typedef struct
+{
+  TDScenarioSpawn spawn;
+  guint order;
+} TDScenarioEntry;
+
+GQuark
+td_scenario_error_quark (void)
+{
+  return g_quark_from_static_string ("td-scenario-error-quark");
+}
+
+static int
+td_scenario_compare (gconstpointer a, gconstpointer b)
+{
+  const TDScenarioEntry *ea = a, *eb = b;
+
+  if (ea->spawn.time != eb->spawn.time)
+    return ea->spawn.time < eb->spawn.time ? -1 : 1;
+
+  return ea->order < eb->order ? -1 : ea->order > eb->order ? 1 : 0;
+}
+
+/* Gets an optional number from the key file. Returns FALSE and sets
+   error if the key is there but isn't a number */
+static gboolean
+td_scenario_get_double (GKeyFile *key_file,
+			const char *group,
+			const char *key,
+			double *value,
+			GError **error)
+{
+  GError *key_error = NULL;
+  double v;
+
+  if (!g_key_file_has_key (key_file, group, key, NULL))
+    return TRUE;
+
+  v = g_key_file_get_double (key_file, group, key, &key_error);
+
+  if (key_error)
+    {
+      g_propagate_error (error, key_error);
+      return FALSE;
+    }
+
+  *value = v;
+
+  return TRUE;
+}
+
+static gboolean
+td_scenario_add_wave (GKeyFile *key_file,
+		      const char *group,
+		      int n_lanes,
+		      GArray *entries,
+		      GError **error)
+{
+  double time = -1.0, count = -1.0, skin = -1.0, speed = 1.0;
+  double interval = 0.0;
+  int *lanes = NULL;
+  gsize n_wave_lanes = 0;
+  int i;
+
+  if (!td_scenario_get_double (key_file, group, "Time", &time, error)
+      || !td_scenario_get_double (key_file, group, "Count", &count, error)
+      || !td_scenario_get_double (key_file, group, "Skin", &skin, error)
+      || !td_scenario_get_double (key_file, group, "Speed", &speed, error)
+      || !td_scenario_get_double (key_file, group, "Interval", &interval,
+				  error))
+    return FALSE;
+
+  if (time < 0.0 || count < 0.0 || speed <= 0.0 || interval < 0.0)
+    {
+      g_set_error (error, TD_SCENARIO_ERROR, TD_SCENARIO_ERROR_INVALID,
+		   "wave [%s] needs a Time and a Count and can't have "
+		   "a negative Speed or Interval", group);
+      return FALSE;
+    }
+
+  if (entries->len + count > TD_SCENARIO_MAX_SPAWNS)
+    {
+      g_set_error (error, TD_SCENARIO_ERROR, TD_SCENARIO_ERROR_INVALID,
+		   "wave [%s] takes the scenario over the limit of %i "
+		   "tractors", group, TD_SCENARIO_MAX_SPAWNS);
+      return FALSE;
+    }
+
+  if (g_key_file_has_key (key_file, group, "Lanes", NULL))
+    {
+      GError *key_error = NULL;
+
+      lanes = g_key_file_get_integer_list (key_file, group, "Lanes",
+					   &n_wave_lanes, &key_error);
+
+      if (key_error)
+	{
+	  g_propagate_error (error, key_error);
+	  return FALSE;
+	}
+
+      for (i = 0; i < n_wave_lanes; i++)
+	if (lanes[i] < 0 || lanes[i] >= n_lanes)
+	  {
+	    g_set_error (error, TD_SCENARIO_ERROR, TD_SCENARIO_ERROR_INVALID,
+			 "wave [%s] uses lane %i but there are only %i",
+			 group, lanes[i], n_lanes);
+	    g_free (lanes);
+	    return FALSE;
+	  }
+    }
+
+  for (i = 0; i < (int) count; i++)
+    {
+      TDScenarioEntry entry;
+      int lane;
+
+      if (n_wave_lanes > 0)
+	lane = lanes[i % n_wave_lanes];
+      else
+	lane = i % n_lanes;
+
+      entry.spawn.time = (guint) ((time + i * interval) * 1000.0 + 0.5);
+      entry.spawn.position = lane / (float) n_lanes;
+      entry.spawn.skin = (int) skin;
+      entry.spawn.speed = speed;
+      entry.order = entries->len;
+
+      g_array_append_val (entries, entry);
+    }
+
+  g_free (lanes);
+
+  return TRUE;
+}
+
+TDScenario *
+td_scenario_load (const char *filename, GError **error)
+{
+  GKeyFile *key_file = g_key_file_new ();
+  GArray *entries;
+  TDScenario *scenario = NULL;
+  char **groups;
+  int n_lanes = 1, i;
+  gboolean invincible = FALSE;
+
+  if (!g_key_file_load_from_file (key_file, filename, 0, error))
+    {
+      g_key_file_free (key_file);
+      return NULL;
+    }
+
+  entries = g_array_new (FALSE, FALSE, sizeof (TDScenarioEntry));
+
+  if (g_key_file_has_key (key_file, TD_SCENARIO_GROUP, "Lanes", NULL))
+    {
+      GError *key_error = NULL;
+
+      n_lanes = g_key_file_get_integer (key_file, TD_SCENARIO_GROUP,
+					"Lanes", &key_error);
+
+      if (key_error)
+	{
+	  g_propagate_error (error, key_error);
+	  goto out;
+	}
+
+      if (n_lanes < 1)
+	{
+	  g_set_error (error, TD_SCENARIO_ERROR, TD_SCENARIO_ERROR_INVALID,
+		       "%s: there must be at least one lane", filename);
+	  goto out;
+	}
+    }
+
+  if (g_key_file_has_key (key_file, TD_SCENARIO_GROUP, "Invincible", NULL))
+    {
+      GError *key_error = NULL;
+
+      invincible = g_key_file_get_boolean (key_file, TD_SCENARIO_GROUP,
+					   "Invincible", &key_error);
+
+      if (key_error)
+	{
+	  g_propagate_error (error, key_error);
+	  goto out;
+	}
+    }
+
+  groups = g_key_file_get_groups (key_file, NULL);
+
+  for (i = 0; groups[i]; i++)
+    if (strcmp (groups[i], TD_SCENARIO_GROUP)
+	&& !td_scenario_add_wave (key_file, groups[i], n_lanes,
+				  entries, error))
+      {
+	g_strfreev (groups);
+	goto out;
+      }
+
+  g_strfreev (groups);
+
+  g_array_sort (entries, td_scenario_compare);
+
+  scenario = g_slice_new0 (TDScenario);
+  scenario->name = g_key_file_get_string (key_file, TD_SCENARIO_GROUP,
+					  "Name", NULL);
+  if (scenario->name == NULL)
+    scenario->name = g_path_get_basename (filename);
+  scenario->invincible = invincible;
+
+  scenario->n_spawns = entries->len;
+  scenario->spawns = g_new (TDScenarioSpawn, entries->len);
+  for (i = 0; i < entries->len; i++)
+    scenario->spawns[i] = g_array_index (entries, TDScenarioEntry, i).spawn;
+
+ out:
+  g_array_free (entries, TRUE);
+  g_key_file_free (key_file);
+
+  return scenario;
+}
+
+void
+td_scenario_free (TDScenario *scenario)
+{
+  g_free (scenario->name);
+  g_free (scenario->spawns);
+
+  g_slice_free (TDScenario, scenario);
+}
+
+const char *
+td_scenario_get_name (const TDScenario *scenario)
+{
+  return scenario->name;
+}
+
+/* Whether the car should keep going after hitting a tractor */
+gboolean
+td_scenario_get_invincible (const TDScenario *scenario)
+{
+  return scenario->invincible;
+}
+
+/* Gets every tractor in the scenario in the order they appear */
+const TDScenarioSpawn *
+td_scenario_get_spawns (const TDScenario *scenario, guint *n_spawns)
+{
+  *n_spawns = scenario->n_spawns;
+
+  return scenario->spawns;
+}
@@ -0,0 +1,69 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_SCENARIO_H
+#define _HAVE_TD_SCENARIO_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define TD_SCENARIO_ERROR (td_scenario_error_quark ())
+
+typedef enum
+{
+  TD_SCENARIO_ERROR_INVALID
+} TDScenarioError;
+
+typedef struct _TDScenario      TDScenario;
+typedef struct _TDScenarioSpawn TDScenarioSpawn;
+
+/* A single tractor to add to the road */
+struct _TDScenarioSpawn
+{
+  /* Milliseconds after the start of the game */
+  guint time;
+  /* Position of the left of the tractor across the road in the range
+     [0,1) or -1 to pick one at random */
+  float position;
+  /* Skin to use or -1 for a random one */
+  int skin;
+  /* How many times faster than normal the tractor drives */
+  float speed;
+};
+
+GQuark td_scenario_error_quark (void);
+
+TDScenario *td_scenario_load (const char *filename, GError **error);
+void td_scenario_free (TDScenario *scenario);
+
+const char *td_scenario_get_name (const TDScenario *scenario);
+gboolean td_scenario_get_invincible (const TDScenario *scenario);
+const TDScenarioSpawn *td_scenario_get_spawns (const TDScenario *scenario,
+					       guint *n_spawns);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_SCENARIO_H */
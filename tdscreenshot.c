@@ -0,0 +1,135 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <time.h>
+
+#include "tdscreenshot.h"
+#include "tdpixels.h"
+
+/* Screenshots are converted and encoded on a worker thread so that
+   the main loop only has to pay for reading back the pixels */
+
+typedef struct _TDScreenshot TDScreenshot;
+
+struct _TDScreenshot
+{
+  guchar *pixels;
+  int width, height;
+  GTimeVal time;
+  /* Time taken to read the pixels back in seconds */
+  gdouble capture_time;
+};
+
+static GThreadPool *td_screenshot_pool = NULL;
+
+static gchar *
+td_screenshot_make_filename (const GTimeVal *time)
+{
+  char stamp[32];
+  time_t secs = time->tv_sec;
+  struct tm tm;
+
+  localtime_r (&secs, &tm);
+  strftime (stamp, sizeof (stamp), "%Y%m%d-%H%M%S", &tm);
+
+  return g_strdup_printf ("screenie-%s-%03li.png",
+			  stamp, time->tv_usec / 1000);
+}
+
+static void
+td_screenshot_write (gpointer data, gpointer user_data)
+{
+  TDScreenshot *screenshot = data;
+  GTimer *timer = g_timer_new ();
+  GError *error = NULL;
+  gchar *filename;
+  GdkPixbuf *pb;
+
+  /* The stage has no meaningful alpha so make it opaque */
+  td_pixels_set_opaque_rgba (screenshot->pixels,
+			     screenshot->width * screenshot->height);
+
+  pb = gdk_pixbuf_new_from_data (screenshot->pixels,
+				 GDK_COLORSPACE_RGB, TRUE,
+				 8, screenshot->width, screenshot->height,
+				 screenshot->width * 4,
+				 (GdkPixbufDestroyNotify) g_free,
+				 NULL);
+
+  filename = td_screenshot_make_filename (&screenshot->time);
+
+  if (gdk_pixbuf_save (pb, filename, "png", &error, NULL))
+    g_print ("Saved %s (capture %.1fms, encode %.1fms)\n",
+	     filename,
+	     screenshot->capture_time * 1000.0,
+	     g_timer_elapsed (timer, NULL) * 1000.0);
+  else
+    {
+      g_warning ("%s: %s", filename, error->message);
+      g_error_free (error);
+    }
+
+  g_free (filename);
+  g_object_unref (pb);
+  g_timer_destroy (timer);
+
+  g_slice_free (TDScreenshot, screenshot);
+}
+
+/* Queues the pixels to be saved to a PNG named after the current
+   time. This takes ownership of the pixels which must have been
+   allocated with g_malloc */
+void
+td_screenshot_save (guchar *pixels, int width, int height,
+		    gdouble capture_time)
+{
+  TDScreenshot *screenshot = g_slice_new (TDScreenshot);
+
+  screenshot->pixels = pixels;
+  screenshot->width = width;
+  screenshot->height = height;
+  screenshot->capture_time = capture_time;
+  g_get_current_time (&screenshot->time);
+
+  /* Use a single thread so that the screenshots are written in order */
+  if (td_screenshot_pool == NULL)
+    td_screenshot_pool = g_thread_pool_new (td_screenshot_write, NULL,
+					    1, FALSE, NULL);
+
+  g_thread_pool_push (td_screenshot_pool, screenshot, NULL);
+}
+
+/* Waits for any queued screenshots to be written */
+void
+td_screenshot_flush (void)
+{
+  if (td_screenshot_pool)
+    {
+      g_thread_pool_free (td_screenshot_pool, FALSE, TRUE);
+      td_screenshot_pool = NULL;
+    }
+}
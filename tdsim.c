@@ -0,0 +1,816 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+#include <math.h>
+#include <string.h>
+
+#include "tdsim.h"
+#include "tdtimerwheel.h"
+#include "tdsimkernel.h"
+#include "tdprofiler.h"
+
+#define CAR_MAX_ANGLE      25
+
+#define TRACTOR_RATE_MIN   1 /* Seconds */
+#define TRACTOR_RATE_START 10
+
+#define TRACTOR_DURATION   10000 /* Milliseconds to drive the road */
+
+#define ROAD_DURATION      4000 /* Milliseconds for the lines to repeat */
+
+#define ROTATE_SPEED       80 /* Degrees per second */
+#define STRAIGHTEN_SPEED   20
+
+#define FULL_MOVE_SPEED    0.5 /* stage widths per second */
+
+/* The tractor models are turned around to face the car */
+#define TRACTOR_ANGLE      180.0f
+
+/* Number of ticks before the timer wheel wraps around */
+#define TIMER_WHEEL_SLOTS  256
+
+/* Things that can be scheduled on the timer wheel */
+enum
+{
+  TD_SIM_TIMER_ADD_TRACTOR = 1,
+  TD_SIM_TIMER_SCENARIO
+};
+
+struct _TDSim
+{
+  TDSimConfig config;
+
+  TDSimCallbacks callbacks;
+  gpointer callback_data;
+
+  /* Random numbers for the current game, started from seed on every
+     reset */
+  GRand *rand;
+  guint32 seed;
+
+  /* Ticks run since the game started */
+  guint n_ticks;
+
+  /* Time left over from td_sim_advance that didn't fill a whole tick */
+  float remainder;
+
+  float angle;
+  int rotate_direction;
+  float position;
+
+  /* How far the lines on the road have scrolled in the range [0,1) */
+  float road_progress;
+
+  TDSimTractors tractors;
+  /* Number of tractors that the arrays have room for */
+  guint tractors_size;
+  int add_rate;
+
+  /* Index of the next tractor to add from the scenario */
+  guint next_spawn;
+
+  /* Random tractors are added every tick until there are at least
+     this many on the road */
+  guint target_tractors;
+
+  /* Pending events such as adding the next tractor */
+  TDTimerWheel *timers;
+
+  int score;
+
+  gboolean crashed;
+  /* Collisions are still tested but don't end the game */
+  gboolean invincible;
+  /* A scenario skin that doesn't exist is only reported once */
+  gboolean warned_skin;
+
+  /* Uniform grid over the road used to find the tractors near the
+     car. Each cell is the size of a tractor and each tractor is
+     sorted into the cell containing its top left corner so it can
+     only overlap that cell and the cells to the right and below */
+  float grid_left, grid_top;
+  int grid_columns, grid_rows;
+  /* Index into grid_tractors of the first tractor in each cell. There
+     is an extra entry at the end so that grid_start[cell + 1] is
+     always the end of the cell */
+  guint *grid_start;
+  guint *grid_fill;
+  /* Indices of the tractors sorted by cell */
+  guint *grid_tractors;
+  guint grid_tractors_size;
+
+  /* Number of car/tractor pairs tested during the last tick and
+     since the game started */
+  guint n_candidates;
+  guint64 total_candidates;
+};
+
+static void td_sim_schedule_spawn (TDSim *sim);
+
+static void
+td_sim_reset_state (TDSim *sim)
+{
+  g_rand_set_seed (sim->rand, sim->seed);
+  sim->n_ticks = 0;
+  sim->remainder = 0.0f;
+
+  sim->angle = 0.0f;
+  sim->rotate_direction = 0;
+  sim->position = sim->config.stage_width / 2.0f;
+
+  sim->road_progress = 0.0f;
+
+  sim->add_rate = TRACTOR_RATE_START;
+  sim->next_spawn = 0;
+  td_timer_wheel_clear (sim->timers);
+  if (sim->config.scenario)
+    td_sim_schedule_spawn (sim);
+  else
+    /* Add the first tractor straight away */
+    td_timer_wheel_add (sim->timers, 1,
+			GINT_TO_POINTER (TD_SIM_TIMER_ADD_TRACTOR));
+
+  sim->score = 0;
+  sim->crashed = FALSE;
+  sim->n_candidates = 0;
+  sim->total_candidates = 0;
+}
+
+TDSim *
+td_sim_new (const TDSimConfig *config)
+{
+  TDSim *sim = g_slice_new0 (TDSim);
+  int n_cells;
+
+  sim->config = *config;
+  sim->seed = config->seed;
+  sim->rand = g_rand_new_with_seed (sim->seed);
+  sim->timers = td_timer_wheel_new (TIMER_WHEEL_SLOTS);
+
+  /* Tractors can be anywhere from the left of the road to a tractor
+     width past the right and from a tractor height above the road to
+     the end of it */
+  sim->grid_left = config->road_left;
+  sim->grid_top = config->road_start - config->tractor_size;
+  sim->grid_columns = (config->road_width + config->tractor_size * 2 - 1)
+    / config->tractor_size;
+  sim->grid_rows = (config->road_end - config->road_start
+		    + config->tractor_size * 2 - 1)
+    / config->tractor_size;
+  n_cells = sim->grid_columns * sim->grid_rows;
+  sim->grid_start = g_new0 (guint, n_cells + 1);
+  sim->grid_fill = g_new0 (guint, n_cells);
+
+  td_sim_reset_state (sim);
+
+  return sim;
+}
+
+static void
+td_sim_remove_tractor (TDSim *sim, guint index)
+{
+  TDSimTractors *tractors = &sim->tractors;
+  guint last;
+
+  if (sim->callbacks.tractor_removed)
+    sim->callbacks.tractor_removed (sim, index, sim->callback_data);
+
+  /* Fill the gap with the last tractor */
+  last = --tractors->n_tractors;
+  tractors->x[index] = tractors->x[last];
+  tractors->y[index] = tractors->y[last];
+  tractors->progress[index] = tractors->progress[last];
+  tractors->step[index] = tractors->step[last];
+  tractors->skin[index] = tractors->skin[last];
+  tractors->frame[index] = tractors->frame[last];
+  tractors->user_data[index] = tractors->user_data[last];
+}
+
+static void
+td_sim_remove_all_tractors (TDSim *sim)
+{
+  while (sim->tractors.n_tractors > 0)
+    td_sim_remove_tractor (sim, sim->tractors.n_tractors - 1);
+}
+
+void
+td_sim_free (TDSim *sim)
+{
+  td_sim_remove_all_tractors (sim);
+
+  g_free (sim->tractors.x);
+  g_free (sim->tractors.y);
+  g_free (sim->tractors.progress);
+  g_free (sim->tractors.step);
+  g_free (sim->tractors.skin);
+  g_free (sim->tractors.frame);
+  g_free (sim->tractors.user_data);
+  td_timer_wheel_free (sim->timers);
+  g_rand_free (sim->rand);
+
+  g_free (sim->grid_start);
+  g_free (sim->grid_fill);
+  g_free (sim->grid_tractors);
+
+  g_slice_free (TDSim, sim);
+}
+
+/* Removes all of the tractors and puts the car back in the middle of
+   the road ready to start a new game */
+void
+td_sim_reset (TDSim *sim)
+{
+  td_sim_remove_all_tractors (sim);
+
+  td_sim_reset_state (sim);
+}
+
+/* Sets the seed for the next game. The current game carries on with
+   the numbers it was already using */
+void
+td_sim_set_seed (TDSim *sim, guint32 seed)
+{
+  sim->seed = seed;
+}
+
+guint32
+td_sim_get_seed (TDSim *sim)
+{
+  return sim->seed;
+}
+
+void
+td_sim_set_callbacks (TDSim *sim,
+		      const TDSimCallbacks *callbacks,
+		      gpointer user_data)
+{
+  sim->callbacks = *callbacks;
+  sim->callback_data = user_data;
+}
+
+/* Keeps at least n_tractors on the road by topping it up with random
+   tractors at the end of every tick. This is on top of the usual ramp
+   or scenario and is meant for finding how many tractors the game can
+   cope with. Zero turns it off */
+void
+td_sim_set_target_tractors (TDSim *sim, guint n_tractors)
+{
+  sim->target_tractors = n_tractors;
+}
+
+guint
+td_sim_get_target_tractors (TDSim *sim)
+{
+  return sim->target_tractors;
+}
+
+/* Stops collisions from ending the game. They are still tested so a
+   tick costs the same */
+void
+td_sim_set_invincible (TDSim *sim, gboolean invincible)
+{
+  sim->invincible = invincible;
+}
+
+void
+td_sim_set_steer (TDSim *sim, int direction)
+{
+  sim->rotate_direction = direction;
+}
+
+/* Turns the car towards direction, or back to straight if it is
+   zero, and slides it across the stage by one tick. This and
+   td_sim_step_road don't need a TDSim so that they can be benchmarked
+   on their own */
+void
+td_sim_step_car (float *angle_ptr,
+		 float *position_ptr,
+		 int direction,
+		 int stage_width)
+{
+  const float secs = TD_SIM_TICK_LENGTH / 1000.0f;
+  float angle = *angle_ptr, position = *position_ptr;
+
+  if (direction < 0)
+    {
+      angle -= secs * ROTATE_SPEED;
+
+      if (angle < -CAR_MAX_ANGLE)
+	angle = -CAR_MAX_ANGLE;
+    }
+  else if (direction == 0)
+    {
+      float diff = secs * STRAIGHTEN_SPEED;
+
+      if (angle < 0)
+	{
+	  angle += diff;
+	  if (angle > 0)
+	    angle = 0;
+	}
+      else if (angle > 0)
+	{
+	  angle -= diff;
+	  if (angle < 0)
+	    angle = 0;
+	}
+    }
+  else
+    {
+      angle += secs * ROTATE_SPEED;
+
+      if (angle > CAR_MAX_ANGLE)
+	angle = CAR_MAX_ANGLE;
+    }
+
+  if (angle != 0)
+    {
+      float slide_speed = angle * (float) FULL_MOVE_SPEED / CAR_MAX_ANGLE;
+
+      position += secs * slide_speed * stage_width;
+
+      if (position < 0.0f)
+	position = 0.0f;
+      else if (position > stage_width)
+	position = stage_width;
+    }
+
+  *angle_ptr = angle;
+  *position_ptr = position;
+}
+
+/* Scrolls the lines on the road by one tick */
+float
+td_sim_step_road (float road_progress)
+{
+  road_progress += TD_SIM_TICK_LENGTH / (float) ROAD_DURATION;
+
+  if (road_progress >= 1.0f)
+    road_progress -= 1.0f;
+
+  return road_progress;
+}
+
+static void
+td_sim_update_tractors (TDSim *sim)
+{
+  TDSimTractors *tractors = &sim->tractors;
+  float start = sim->config.road_start - sim->config.tractor_size;
+  float length = sim->config.road_end - start;
+  guint i;
+
+  /* Ease in along a quarter sine wave the same way that
+     CLUTTER_ALPHA_SINE_INC does */
+  td_sim_kernel_advance_tractors (tractors->progress, tractors->y,
+				  tractors->step, tractors->n_tractors,
+				  start, length);
+
+  for (i = 0; i < tractors->n_tractors;)
+    if (tractors->progress[i] >= 1.0f)
+      /* The tractor has reached the end of the road */
+      td_sim_remove_tractor (sim, i);
+    else
+      i++;
+}
+
+/* Puts a new tractor at the top of the road. Both the random ramp and
+   scenarios add their tractors through here so that they cost the
+   same */
+static void
+td_sim_spawn_tractor (TDSim *sim, float x, int skin, float step)
+{
+  TDSimTractors *tractors = &sim->tractors;
+  TDProfilerScope scope;
+  guint index;
+
+  td_profiler_begin (&scope, TD_PROFILER_PHASE_SPAWN);
+
+  if (tractors->n_tractors >= sim->tractors_size)
+    {
+      guint size = MAX (sim->tractors_size * 2, 16);
+
+      tractors->x = g_renew (float, tractors->x, size);
+      tractors->y = g_renew (float, tractors->y, size);
+      tractors->progress = g_renew (float, tractors->progress, size);
+      tractors->step = g_renew (float, tractors->step, size);
+      tractors->skin = g_renew (int, tractors->skin, size);
+      tractors->frame = g_renew (int, tractors->frame, size);
+      tractors->user_data = g_renew (gpointer, tractors->user_data, size);
+      sim->tractors_size = size;
+    }
+
+  index = tractors->n_tractors++;
+
+  tractors->x[index] = x;
+  tractors->y[index] = sim->config.road_start - sim->config.tractor_size;
+  tractors->progress[index] = 0.0f;
+  tractors->step[index] = step;
+  tractors->skin[index] = skin;
+  tractors->frame[index] = 0;
+  tractors->user_data[index] = NULL;
+
+  if (sim->callbacks.tractor_added)
+    sim->callbacks.tractor_added (sim, index, sim->callback_data);
+
+  /* Increase the player's score */
+  sim->score++;
+
+  td_profiler_end (&scope);
+}
+
+static void
+td_sim_add_random_tractor (TDSim *sim)
+{
+  float x = g_rand_int_range (sim->rand, 0, sim->config.road_width)
+    + sim->config.road_left;
+  int skin = g_rand_int_range (sim->rand, 0, MAX (sim->config.n_skins, 1));
+
+  td_sim_spawn_tractor (sim, x, skin,
+			TD_SIM_TICK_LENGTH / (float) TRACTOR_DURATION);
+}
+
+static void
+td_sim_add_tractor (TDSim *sim)
+{
+  td_sim_add_random_tractor (sim);
+
+  /* Start another tractor some time later */
+  td_timer_wheel_add (sim->timers,
+		      g_rand_int_range (sim->rand, TRACTOR_RATE_MIN,
+					sim->add_rate + 1)
+		      * 1000 / TD_SIM_TICK_LENGTH,
+		      GINT_TO_POINTER (TD_SIM_TIMER_ADD_TRACTOR));
+  /* Increase the rate for the next tractor */
+  if (sim->add_rate > TRACTOR_RATE_MIN)
+    sim->add_rate--;
+}
+
+/* Gets the tick at the end of which a scenario tractor appears */
+static guint
+td_sim_get_spawn_tick (const TDScenarioSpawn *spawn)
+{
+  return MAX ((spawn->time + TD_SIM_TICK_LENGTH - 1) / TD_SIM_TICK_LENGTH, 1);
+}
+
+/* Sets a timer for the next tractor in the scenario if there is
+   one. Only one timer is ever pending however many tractors are left
+   to come */
+static void
+td_sim_schedule_spawn (TDSim *sim)
+{
+  const TDScenarioSpawn *spawns;
+  guint n_spawns, spawn_tick;
+
+  spawns = td_scenario_get_spawns (sim->config.scenario, &n_spawns);
+
+  if (sim->next_spawn >= n_spawns)
+    return;
+
+  spawn_tick = td_sim_get_spawn_tick (spawns + sim->next_spawn);
+
+  td_timer_wheel_add (sim->timers,
+		      spawn_tick > sim->n_ticks
+		      ? spawn_tick - sim->n_ticks : 1,
+		      GINT_TO_POINTER (TD_SIM_TIMER_SCENARIO));
+}
+
+static void
+td_sim_add_scenario_tractors (TDSim *sim)
+{
+  const TDScenarioSpawn *spawns;
+  guint n_spawns;
+
+  spawns = td_scenario_get_spawns (sim->config.scenario, &n_spawns);
+
+  for (; sim->next_spawn < n_spawns; sim->next_spawn++)
+    {
+      const TDScenarioSpawn *spawn = spawns + sim->next_spawn;
+      float x;
+      int skin;
+
+      if (td_sim_get_spawn_tick (spawn) > sim->n_ticks)
+	break;
+
+      if (spawn->position < 0.0f)
+	x = g_rand_int_range (sim->rand, 0, sim->config.road_width);
+      else
+	x = spawn->position * sim->config.road_width;
+
+      if (spawn->skin >= sim->config.n_skins && !sim->warned_skin)
+	{
+	  g_warning ("scenario skin %i doesn't exist, there are only %i. "
+		     "A random skin is used instead",
+		     spawn->skin, sim->config.n_skins);
+	  sim->warned_skin = TRUE;
+	}
+
+      if (spawn->skin < 0 || spawn->skin >= sim->config.n_skins)
+	skin = g_rand_int_range (sim->rand, 0, MAX (sim->config.n_skins, 1));
+      else
+	skin = spawn->skin;
+
+      td_sim_spawn_tractor (sim, x + sim->config.road_left, skin,
+			    spawn->speed * TD_SIM_TICK_LENGTH
+			    / (float) TRACTOR_DURATION);
+    }
+
+  td_sim_schedule_spawn (sim);
+}
+
+static int
+td_sim_get_column (TDSim *sim, float x)
+{
+  int column = (int) floorf ((x - sim->grid_left) / sim->config.tractor_size);
+
+  return CLAMP (column, 0, sim->grid_columns - 1);
+}
+
+static int
+td_sim_get_row (TDSim *sim, float y)
+{
+  int row = (int) floorf ((y - sim->grid_top) / sim->config.tractor_size);
+
+  return CLAMP (row, 0, sim->grid_rows - 1);
+}
+
+static void
+td_sim_build_grid (TDSim *sim)
+{
+  const TDSimTractors *tractors = &sim->tractors;
+  int n_cells = sim->grid_columns * sim->grid_rows;
+  guint n_tractors = tractors->n_tractors;
+  guint i;
+  int cell;
+
+  if (n_tractors > sim->grid_tractors_size)
+    {
+      sim->grid_tractors_size = MAX (sim->grid_tractors_size * 2, n_tractors);
+      sim->grid_tractors = g_renew (guint, sim->grid_tractors,
+				    sim->grid_tractors_size);
+    }
+
+  /* Count the tractors in each cell */
+  memset (sim->grid_start, 0, sizeof (guint) * (n_cells + 1));
+  for (i = 0; i < n_tractors; i++)
+    {
+      cell = (td_sim_get_row (sim, tractors->y[i]) * sim->grid_columns
+	      + td_sim_get_column (sim, tractors->x[i]));
+      sim->grid_start[cell + 1]++;
+    }
+
+  /* Convert the counts to offsets */
+  for (cell = 0; cell < n_cells; cell++)
+    {
+      sim->grid_start[cell + 1] += sim->grid_start[cell];
+      sim->grid_fill[cell] = sim->grid_start[cell];
+    }
+
+  for (i = 0; i < n_tractors; i++)
+    {
+      cell = (td_sim_get_row (sim, tractors->y[i]) * sim->grid_columns
+	      + td_sim_get_column (sim, tractors->x[i]));
+      sim->grid_tractors[sim->grid_fill[cell]++] = i;
+    }
+}
+
+static void
+td_sim_get_hit_box (const TDHitBoxes *boxes,
+		    int frame, float angle,
+		    float x, float y, float size,
+		    TDHitBox *box)
+{
+  if (boxes)
+    {
+      td_hit_boxes_get_box (boxes, frame, angle, box);
+
+      box->x1 = x + box->x1 * size;
+      box->x2 = x + box->x2 * size;
+      box->y1 = y + box->y1 * size;
+      box->y2 = y + box->y2 * size;
+    }
+  else
+    {
+      box->x1 = x;
+      box->x2 = x + size;
+      box->y1 = y;
+      box->y2 = y + size;
+    }
+}
+
+/* Tests the models' keyframe boxes against each other once the
+   squares of the actors are known to overlap */
+static gboolean
+td_sim_hit_test (TDSim *sim, guint index, const TDHitBox *car_box)
+{
+  const TDSimTractors *tractors = &sim->tractors;
+  TDHitBox tractor_box;
+
+  td_sim_get_hit_box (sim->config.tractor_boxes,
+		      tractors->frame[index], TRACTOR_ANGLE,
+		      tractors->x[index], tractors->y[index],
+		      sim->config.tractor_size,
+		      &tractor_box);
+
+  return (tractor_box.x1 < car_box->x2
+	  && tractor_box.x2 > car_box->x1
+	  && tractor_box.y1 < car_box->y2
+	  && tractor_box.y2 > car_box->y1);
+}
+
+static gboolean
+td_sim_check_collisions (TDSim *sim)
+{
+  const TDSimTractors *tractors = &sim->tractors;
+  TDHitBox car_box;
+  float car_x = sim->position - sim->config.car_size / 2.0f;
+  float car_y = sim->config.car_y;
+  int first_column, last_column, first_row, last_row;
+  int row, column;
+  guint i;
+
+  td_sim_build_grid (sim);
+
+  sim->n_candidates = 0;
+
+  td_sim_get_hit_box (sim->config.car_boxes, 0, sim->angle,
+		      car_x, car_y, sim->config.car_size,
+		      &car_box);
+
+  /* A tractor that overlaps the car must have its top left corner in
+     one of the cells covered by the car or in the cells to the left
+     or above */
+  first_column = td_sim_get_column (sim, car_x - sim->config.tractor_size);
+  last_column = td_sim_get_column (sim, car_x + sim->config.car_size);
+  first_row = td_sim_get_row (sim, car_y - sim->config.tractor_size);
+  last_row = td_sim_get_row (sim, car_y + sim->config.car_size);
+
+  for (row = first_row; row <= last_row; row++)
+    for (column = first_column; column <= last_column; column++)
+      {
+	int cell = row * sim->grid_columns + column;
+
+	for (i = sim->grid_start[cell]; i < sim->grid_start[cell + 1]; i++)
+	  {
+	    guint index = sim->grid_tractors[i];
+	    float x = tractors->x[index], y = tractors->y[index];
+
+	    sim->n_candidates++;
+	    sim->total_candidates++;
+
+	    if (x < car_x + sim->config.car_size
+		&& x + sim->config.tractor_size > car_x
+		&& y < car_y + sim->config.car_size
+		&& y + sim->config.tractor_size > car_y
+		&& td_sim_hit_test (sim, index, &car_box))
+	      return TRUE;
+	  }
+      }
+
+  return FALSE;
+}
+
+static void
+td_sim_on_timer (gpointer data, gpointer user_data)
+{
+  TDSim *sim = user_data;
+
+  switch (GPOINTER_TO_INT (data))
+    {
+    case TD_SIM_TIMER_ADD_TRACTOR:
+      td_sim_add_tractor (sim);
+      break;
+
+    case TD_SIM_TIMER_SCENARIO:
+      td_sim_add_scenario_tractors (sim);
+      break;
+    }
+}
+
+/* Advances the road, the car and every tractor by one step */
+void
+td_sim_tick (TDSim *sim)
+{
+  if (sim->crashed)
+    return;
+
+  if (sim->callbacks.tick)
+    sim->callbacks.tick (sim, sim->n_ticks, sim->callback_data);
+  sim->n_ticks++;
+
+  sim->road_progress = td_sim_step_road (sim->road_progress);
+  td_sim_step_car (&sim->angle, &sim->position,
+		   sim->rotate_direction, sim->config.stage_width);
+  td_sim_update_tractors (sim);
+
+  if (td_sim_check_collisions (sim) && !sim->invincible)
+    {
+      sim->crashed = TRUE;
+      return;
+    }
+
+  td_timer_wheel_advance (sim->timers, td_sim_on_timer, sim);
+
+  while (sim->tractors.n_tractors < sim->target_tractors)
+    td_sim_add_random_tractor (sim);
+}
+
+/* Runs as many whole ticks as fit into msecs plus whatever was left
+   over from the last call. Returns the number of ticks run */
+guint
+td_sim_advance (TDSim *sim, float msecs)
+{
+  guint n_ticks = 0;
+
+  sim->remainder += msecs;
+
+  while (sim->remainder >= TD_SIM_TICK_LENGTH && !sim->crashed)
+    {
+      td_sim_tick (sim);
+      sim->remainder -= TD_SIM_TICK_LENGTH;
+      n_ticks++;
+    }
+
+  return n_ticks;
+}
+
+/* Gets the number of ticks since the game started. This is the
+   number that will be passed to the tick callback next */
+guint
+td_sim_get_n_ticks (TDSim *sim)
+{
+  return sim->n_ticks;
+}
+
+float
+td_sim_get_road_progress (TDSim *sim)
+{
+  return sim->road_progress;
+}
+
+float
+td_sim_get_car_angle (TDSim *sim)
+{
+  return sim->angle;
+}
+
+float
+td_sim_get_car_position (TDSim *sim)
+{
+  return sim->position;
+}
+
+int
+td_sim_get_score (TDSim *sim)
+{
+  return sim->score;
+}
+
+gboolean
+td_sim_is_crashed (TDSim *sim)
+{
+  return sim->crashed;
+}
+
+guint
+td_sim_get_n_candidates (TDSim *sim)
+{
+  return sim->n_candidates;
+}
+
+/* Gets the number of pairs tested over every tick since the game
+   started. A frame can run several ticks so this should be used
+   rather than summing td_sim_get_n_candidates once per frame */
+guint64
+td_sim_get_total_candidates (TDSim *sim)
+{
+  return sim->total_candidates;
+}
+
+const TDSimTractors *
+td_sim_get_tractors (TDSim *sim)
+{
+  return &sim->tractors;
+}
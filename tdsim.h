@@ -0,0 +1,148 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_SIM_H
+#define _HAVE_TD_SIM_H
+
+#include <glib.h>
+
+#include "tdhitboxes.h"
+#include "tdscenario.h"
+
+G_BEGIN_DECLS
+
+/* Length of a single simulation step in milliseconds. The game state
+   only ever advances in whole steps of this size so that it behaves
+   the same regardless of the frame rate */
+#define TD_SIM_TICK_LENGTH 10
+
+typedef struct _TDSim          TDSim;
+typedef struct _TDSimConfig    TDSimConfig;
+typedef struct _TDSimTractors  TDSimTractors;
+typedef struct _TDSimCallbacks TDSimCallbacks;
+
+struct _TDSimConfig
+{
+  int stage_width;
+  int road_left, road_width;
+  int road_start, road_end;
+  int tractor_size;
+  int n_skins;
+
+  /* Size of the car and the position of its top edge. The car always
+     stays at the same height */
+  int car_size, car_y;
+
+  /* Tight boxes around each keyframe of the models. If these are
+     NULL then the whole square of the actor is used */
+  const TDHitBoxes *tractor_boxes;
+  const TDHitBoxes *car_boxes;
+
+  /* Seed for the random numbers that place the tractors. Every game
+     started with the same seed and the same steering on the same
+     ticks plays out the same */
+  guint32 seed;
+
+  /* Timed list of tractors to add instead of the usual random ramp
+     that gets faster as the game goes on. This can be NULL */
+  const TDScenario *scenario;
+};
+
+/* The state of every tractor as parallel arrays so that a tick can
+   update them all with a vectorized kernel. Removing a tractor moves
+   the last one into its place and the arrays are reallocated as
+   tractors are added so indices and pointers are only valid until the
+   next tick */
+struct _TDSimTractors
+{
+  guint n_tractors;
+
+  /* Position of the top left corner of each tractor */
+  float *x, *y;
+  /* How far along the road each tractor is in the range [0,1] */
+  float *progress;
+  /* How much each tractor's progress goes up every tick */
+  float *step;
+  int *skin;
+  /* Keyframe of the model that each tractor is showing */
+  int *frame;
+
+  /* Slots for the front end to attach its actors */
+  gpointer *user_data;
+};
+
+struct _TDSimCallbacks
+{
+  void (* tractor_added) (TDSim *sim, guint index, gpointer user_data);
+  /* Called before the tractor is removed so its state is still at
+     index */
+  void (* tractor_removed) (TDSim *sim, guint index, gpointer user_data);
+  /* Called at the start of every tick before anything moves. This is
+     the place to steer when the timing needs to be exact */
+  void (* tick) (TDSim *sim, guint tick, gpointer user_data);
+};
+
+TDSim *td_sim_new (const TDSimConfig *config);
+void td_sim_free (TDSim *sim);
+
+void td_sim_reset (TDSim *sim);
+
+void td_sim_set_seed (TDSim *sim, guint32 seed);
+guint32 td_sim_get_seed (TDSim *sim);
+
+void td_sim_set_callbacks (TDSim *sim,
+			   const TDSimCallbacks *callbacks,
+			   gpointer user_data);
+
+void td_sim_set_target_tractors (TDSim *sim, guint n_tractors);
+guint td_sim_get_target_tractors (TDSim *sim);
+void td_sim_set_invincible (TDSim *sim, gboolean invincible);
+
+void td_sim_set_steer (TDSim *sim, int direction);
+
+void td_sim_tick (TDSim *sim);
+guint td_sim_advance (TDSim *sim, float msecs);
+
+guint td_sim_get_n_ticks (TDSim *sim);
+float td_sim_get_road_progress (TDSim *sim);
+float td_sim_get_car_angle (TDSim *sim);
+float td_sim_get_car_position (TDSim *sim);
+int td_sim_get_score (TDSim *sim);
+
+gboolean td_sim_is_crashed (TDSim *sim);
+guint td_sim_get_n_candidates (TDSim *sim);
+guint64 td_sim_get_total_candidates (TDSim *sim);
+
+const TDSimTractors *td_sim_get_tractors (TDSim *sim);
+
+void td_sim_step_car (float *angle,
+		      float *position,
+		      int direction,
+		      int stage_width);
+float td_sim_step_road (float road_progress);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_SIM_H */
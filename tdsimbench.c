@@ -0,0 +1,388 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Runs the game simulation without a stage as fast as possible and
+   reports how many ticks it managed per second. Then measures how
+   long each version of the tractor update kernel takes per tractor.
+   If REPLAY_INPUT names a log recorded by the game with the default
+   stage size then that game is also played back repeatedly. If
+   SCENARIO names a scenario file then the tractors are added from
+   that instead of the usual ramp. The ticks per second are added to
+   the benchmark history if BENCH_HISTORY names one */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tdsim.h"
+#include "tdmd2file.h"
+#include "tdhitboxes.h"
+#include "tdsimkernel.h"
+#include "tdinputlog.h"
+#include "tdscenario.h"
+#include "tdbenchhistory.h"
+
+#define STAGE_WIDTH   640
+#define STAGE_HEIGHT  480
+
+#define DEFAULT_TICKS 1000000
+
+static TDHitBoxes *
+load_hit_boxes (const char *filename)
+{
+  TDMD2File *file;
+  TDHitBoxes *boxes;
+  GError *error = NULL;
+
+  if ((file = td_md2_file_load (filename, &error)) == NULL)
+    {
+      /* Fall back to testing against the whole square */
+      g_warning ("%s", error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  boxes = td_hit_boxes_new (file);
+  td_md2_file_free (file);
+
+  return boxes;
+}
+
+/* Number of ticks to hold each steering direction for */
+#define STEER_TICKS   50
+
+/* Minimum time to spend measuring each version of the kernel */
+#define MIN_SECONDS   0.2
+
+/* Number of ticks to run the kernel for before putting the tractors
+   back to the start so they never reach the end of the road */
+#define KERNEL_TICKS  400
+
+static const int kernel_sizes[] = { 16, 256, 4096, 65536 };
+
+static gdouble
+measure_kernel (float *progress, float *y, const float *step,
+		const float *start_progress, int n_tractors)
+{
+  GTimer *timer = g_timer_new ();
+  gdouble elapsed;
+  guint64 n_updates = 0;
+  int i;
+
+  g_timer_stop (timer);
+
+  do
+    {
+      memcpy (progress, start_progress, n_tractors * sizeof (float));
+
+      g_timer_continue (timer);
+      for (i = 0; i < KERNEL_TICKS; i++)
+	td_sim_kernel_advance_tractors (progress, y, step, n_tractors,
+					-480.0f, 1440.0f);
+      g_timer_stop (timer);
+
+      n_updates += (guint64) KERNEL_TICKS * n_tractors;
+    }
+  while ((elapsed = g_timer_elapsed (timer, NULL)) < MIN_SECONDS);
+
+  g_timer_destroy (timer);
+
+  /* Nanoseconds per tractor per tick */
+  return elapsed * 1e9 / n_updates;
+}
+
+static void
+bench_kernel (void)
+{
+  TDSimKernelImpl impl, best_impl = td_sim_kernel_get_impl ();
+  int max_tractors = kernel_sizes[G_N_ELEMENTS (kernel_sizes) - 1];
+  float *start_progress = g_new (float, max_tractors);
+  float *progress = g_new (float, max_tractors);
+  float *y = g_new (float, max_tractors);
+  float *step = g_new (float, max_tractors);
+  float *expected_y = g_new (float, max_tractors);
+  GRand *rand = g_rand_new_with_seed (42);
+  int size, i;
+
+  for (i = 0; i < max_tractors; i++)
+    {
+      start_progress[i] = g_rand_double_range (rand, 0.0, 0.5);
+      step[i] = 0.001f;
+    }
+
+  for (size = 0; size < G_N_ELEMENTS (kernel_sizes); size++)
+    {
+      int n_tractors = kernel_sizes[size];
+
+      g_print ("tractor update, %i tractors:\n", n_tractors);
+
+      for (impl = TD_SIM_KERNEL_IMPL_SCALAR;
+	   impl <= TD_SIM_KERNEL_IMPL_AVX2;
+	   impl++)
+	{
+	  gdouble ns;
+
+	  if (!td_sim_kernel_set_impl (impl))
+	    continue;
+
+	  ns = measure_kernel (progress, y, step, start_progress, n_tractors);
+
+	  /* Every version should move the tractors to the same place */
+	  memcpy (progress, start_progress, n_tractors * sizeof (float));
+	  td_sim_kernel_advance_tractors (progress, y, step, n_tractors,
+					  -480.0f, 1440.0f);
+	  if (impl == TD_SIM_KERNEL_IMPL_SCALAR)
+	    memcpy (expected_y, y, n_tractors * sizeof (float));
+
+	  g_print ("  %-6s %8.3f ns/tractor%s\n",
+		   td_sim_kernel_get_impl_name (impl), ns,
+		   memcmp (expected_y, y, n_tractors * sizeof (float))
+		   ? " MISMATCH" : "");
+	}
+    }
+
+  td_sim_kernel_set_impl (best_impl);
+
+  g_rand_free (rand);
+  g_free (start_progress);
+  g_free (progress);
+  g_free (y);
+  g_free (step);
+  g_free (expected_y);
+}
+
+/* Number of times to play back a recorded game */
+#define REPLAY_RUNS   20
+
+/* Give up on a replayed game that never crashes after this many
+   ticks */
+#define REPLAY_MAX_TICKS 1000000
+
+static void
+on_replay_tick (TDSim *sim, guint tick, gpointer user_data)
+{
+  int direction;
+
+  if (td_input_log_get_steer (user_data, tick, &direction))
+    td_sim_set_steer (sim, direction);
+}
+
+/* Plays back a recorded game as fast as possible. The rate of each
+   run is a sample of sim.replay_ticks_per_sec in the history */
+static void
+bench_replay (const TDSimConfig *base_config, const char *filename,
+	      TDBenchHistory *history)
+{
+  static const TDSimCallbacks callbacks = { NULL, NULL, on_replay_tick };
+  TDSimConfig config = *base_config;
+  TDInputLog *log;
+  GError *error = NULL;
+  TDSim *sim;
+  GTimer *timer;
+  guint64 total_ticks = 0;
+  int first_score = 0, run;
+  guint first_ticks = 0;
+  gboolean identical = TRUE;
+  gdouble elapsed, run_start;
+  double ticks_per_sec[REPLAY_RUNS];
+
+  if ((log = td_input_log_load (filename, &error)) == NULL)
+    {
+      g_warning ("%s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  config.seed = td_input_log_get_seed (log);
+  sim = td_sim_new (&config);
+  td_sim_set_callbacks (sim, &callbacks, log);
+
+  timer = g_timer_new ();
+
+  for (run = 0; run < REPLAY_RUNS; run++)
+    {
+      td_input_log_rewind (log);
+      td_sim_reset (sim);
+
+      run_start = g_timer_elapsed (timer, NULL);
+
+      while (!td_sim_is_crashed (sim)
+	     && td_sim_get_n_ticks (sim) < REPLAY_MAX_TICKS)
+	td_sim_tick (sim);
+
+      ticks_per_sec[run] = (td_sim_get_n_ticks (sim)
+			    / (g_timer_elapsed (timer, NULL) - run_start));
+      total_ticks += td_sim_get_n_ticks (sim);
+
+      /* Every run of the same log should end the same way */
+      if (run == 0)
+	{
+	  first_score = td_sim_get_score (sim);
+	  first_ticks = td_sim_get_n_ticks (sim);
+	}
+      else if (td_sim_get_score (sim) != first_score
+	       || td_sim_get_n_ticks (sim) != first_ticks)
+	identical = FALSE;
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_print ("replay %s:\n"
+	   "  seed: %u, %u steering events\n"
+	   "  final score: %i after %u ticks\n"
+	   "  ticks/sec: %.0f over %i runs%s\n",
+	   filename,
+	   config.seed, td_input_log_get_n_events (log),
+	   first_score, first_ticks,
+	   total_ticks / elapsed, REPLAY_RUNS,
+	   identical ? "" : " (RUNS DIFFER)");
+
+  if (history)
+    td_bench_history_add (history, "sim.replay_ticks_per_sec",
+			  TD_BENCH_HIGHER_IS_BETTER,
+			  ticks_per_sec, REPLAY_RUNS);
+
+  g_timer_destroy (timer);
+  td_sim_free (sim);
+  td_input_log_free (log);
+}
+
+int
+main (int argc, char **argv)
+{
+  TDSimConfig config;
+  TDHitBoxes *tractor_boxes, *car_boxes;
+  TDScenario *scenario = NULL;
+  TDBenchHistory *history = td_bench_history_open_from_env ();
+  TDSim *sim;
+  GRand *rand;
+  GTimer *timer;
+  guint n_ticks = DEFAULT_TICKS, i;
+  guint n_crashes = 0;
+  guint64 n_candidates = 0;
+  gdouble elapsed;
+
+  if (argc > 1)
+    n_ticks = strtoul (argv[1], NULL, 10);
+
+  config.stage_width = STAGE_WIDTH;
+  config.road_left = STAGE_WIDTH / 8;
+  config.road_width = STAGE_WIDTH * 3 / 4;
+  config.road_start = STAGE_HEIGHT - STAGE_HEIGHT * 3;
+  config.road_end = STAGE_HEIGHT;
+  config.tractor_size = STAGE_WIDTH * 3 / 16;
+  config.n_skins = 2;
+  config.car_size = config.tractor_size * 3 / 4;
+  config.car_y = STAGE_HEIGHT - config.car_size * 4 / 3;
+  config.tractor_boxes = tractor_boxes
+    = load_hit_boxes ("data/tractor/tractor.md2");
+  config.car_boxes = car_boxes = load_hit_boxes ("data/car/car.md2");
+  config.seed = 42;
+  config.scenario = NULL;
+
+  if (getenv ("SCENARIO"))
+    {
+      GError *error = NULL;
+
+      if ((scenario = td_scenario_load (getenv ("SCENARIO"), &error)) == NULL)
+	{
+	  g_critical ("%s", error->message);
+	  g_error_free (error);
+	  return 1;
+	}
+
+      config.scenario = scenario;
+    }
+
+  sim = td_sim_new (&config);
+  if (scenario && td_scenario_get_invincible (scenario))
+    td_sim_set_invincible (sim, TRUE);
+  /* Use a fixed sequence of steering so that every run does the same
+     amount of work */
+  rand = g_rand_new_with_seed (42);
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_ticks; i++)
+    {
+      if (i % STEER_TICKS == 0)
+	td_sim_set_steer (sim, g_rand_int_range (rand, -1, 2));
+
+      td_sim_tick (sim);
+      n_candidates += td_sim_get_n_candidates (sim);
+
+      if (td_sim_is_crashed (sim))
+	{
+	  /* Start a new game so the road keeps filling up */
+	  td_sim_reset (sim);
+	  n_crashes++;
+	}
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_print ("ticks: %u\n"
+	   "seconds: %f\n"
+	   "ticks/sec: %.0f\n"
+	   "crashes: %u\n"
+	   "collision pairs tested: %.2f per tick\n"
+	   "final score: %i\n",
+	   n_ticks, elapsed, n_ticks / elapsed,
+	   n_crashes, n_candidates / (double) n_ticks,
+	   td_sim_get_score (sim));
+
+  g_timer_destroy (timer);
+  g_rand_free (rand);
+  td_sim_free (sim);
+
+  if (history)
+    {
+      double ticks_per_sec = n_ticks / elapsed;
+
+      /* A scenario is a different load so it gets its own metric */
+      td_bench_history_add (history,
+			    scenario
+			    ? "sim.scenario_ticks_per_sec"
+			    : "sim.ticks_per_sec",
+			    TD_BENCH_HIGHER_IS_BETTER, &ticks_per_sec, 1);
+    }
+
+  if (getenv ("REPLAY_INPUT"))
+    bench_replay (&config, getenv ("REPLAY_INPUT"), history);
+
+  if (tractor_boxes)
+    td_hit_boxes_free (tractor_boxes);
+  if (car_boxes)
+    td_hit_boxes_free (car_boxes);
+
+  if (scenario)
+    td_scenario_free (scenario);
+
+  bench_kernel ();
+
+  if (history)
+    td_bench_history_save_and_free (history);
+
+  return 0;
+}
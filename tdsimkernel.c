@@ -0,0 +1,289 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+
+#include "tdsimkernel.h"
+
+/* The per-tick update of the tractors. It works on the arrays of the
+   simulation's tractor state so the SIMD versions can move several
+   tractors at once. They are picked at runtime depending on what the
+   CPU supports */
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define TD_SIM_KERNEL_HAVE_X86
+#include <immintrin.h>
+#endif
+
+/* The easing uses sin(x) for x in [0,pi/2]. There's no vector sine so
+   every version uses the same Taylor series up to x^9 evaluated in the
+   same order. The error is below 4e-6 so it is well under a pixel
+   and all of the versions give identical results */
+#define SIN_C3 (-1.0f / 6.0f)
+#define SIN_C5 (1.0f / 120.0f)
+#define SIN_C7 (-1.0f / 5040.0f)
+#define SIN_C9 (1.0f / 362880.0f)
+
+#define HALF_PI ((float) G_PI_2)
+
+typedef void (* TDSimKernelAdvanceFunc) (float *progress,
+					 float *y,
+					 const float *step,
+					 int n_tractors,
+					 float start,
+					 float length);
+
+static TDSimKernelImpl td_sim_kernel_impl;
+static TDSimKernelAdvanceFunc td_sim_kernel_advance_func;
+
+/* Adds each tractor's step to its progress and moves it to the eased
+   position along the road */
+static void
+td_sim_kernel_advance_scalar (float *progress,
+			      float *y,
+			      const float *step,
+			      int n_tractors,
+			      float start,
+			      float length)
+{
+  int i;
+
+  for (i = 0; i < n_tractors; i++)
+    {
+      float x, x2, p;
+
+      progress[i] += step[i];
+
+      x = progress[i] * HALF_PI;
+      x2 = x * x;
+      p = SIN_C9;
+      p = p * x2 + SIN_C7;
+      p = p * x2 + SIN_C5;
+      p = p * x2 + SIN_C3;
+      p = p * x2 + 1.0f;
+
+      y[i] = start + length * (p * x);
+    }
+}
+
+#ifdef TD_SIM_KERNEL_HAVE_X86
+
+__attribute__ ((target ("sse2")))
+static void
+td_sim_kernel_advance_sse2 (float *progress,
+			    float *y,
+			    const float *step,
+			    int n_tractors,
+			    float start,
+			    float length)
+{
+  const __m128 vstart = _mm_set1_ps (start);
+  const __m128 vlength = _mm_set1_ps (length);
+  const __m128 half_pi = _mm_set1_ps (HALF_PI);
+  int i;
+
+  for (i = 0; i + 4 <= n_tractors; i += 4)
+    {
+      __m128 pr = _mm_add_ps (_mm_loadu_ps (progress + i),
+			      _mm_loadu_ps (step + i));
+      __m128 x = _mm_mul_ps (pr, half_pi);
+      __m128 x2 = _mm_mul_ps (x, x);
+      __m128 p = _mm_set1_ps (SIN_C9);
+
+      p = _mm_add_ps (_mm_mul_ps (p, x2), _mm_set1_ps (SIN_C7));
+      p = _mm_add_ps (_mm_mul_ps (p, x2), _mm_set1_ps (SIN_C5));
+      p = _mm_add_ps (_mm_mul_ps (p, x2), _mm_set1_ps (SIN_C3));
+      p = _mm_add_ps (_mm_mul_ps (p, x2), _mm_set1_ps (1.0f));
+
+      _mm_storeu_ps (progress + i, pr);
+      _mm_storeu_ps (y + i, _mm_add_ps (vstart,
+					_mm_mul_ps (vlength,
+						    _mm_mul_ps (p, x))));
+    }
+
+  td_sim_kernel_advance_scalar (progress + i, y + i, step + i,
+				n_tractors - i, start, length);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+td_sim_kernel_advance_avx2 (float *progress,
+			    float *y,
+			    const float *step,
+			    int n_tractors,
+			    float start,
+			    float length)
+{
+  const __m256 vstart = _mm256_set1_ps (start);
+  const __m256 vlength = _mm256_set1_ps (length);
+  const __m256 half_pi = _mm256_set1_ps (HALF_PI);
+  int i;
+
+  /* FMA isn't used so that the rounding matches the other versions */
+  for (i = 0; i + 8 <= n_tractors; i += 8)
+    {
+      __m256 pr = _mm256_add_ps (_mm256_loadu_ps (progress + i),
+				 _mm256_loadu_ps (step + i));
+      __m256 x = _mm256_mul_ps (pr, half_pi);
+      __m256 x2 = _mm256_mul_ps (x, x);
+      __m256 p = _mm256_set1_ps (SIN_C9);
+
+      p = _mm256_add_ps (_mm256_mul_ps (p, x2), _mm256_set1_ps (SIN_C7));
+      p = _mm256_add_ps (_mm256_mul_ps (p, x2), _mm256_set1_ps (SIN_C5));
+      p = _mm256_add_ps (_mm256_mul_ps (p, x2), _mm256_set1_ps (SIN_C3));
+      p = _mm256_add_ps (_mm256_mul_ps (p, x2), _mm256_set1_ps (1.0f));
+
+      _mm256_storeu_ps (progress + i, pr);
+      _mm256_storeu_ps (y + i,
+			_mm256_add_ps (vstart,
+				       _mm256_mul_ps (vlength,
+						      _mm256_mul_ps (p, x))));
+    }
+
+  /* GCC doesn't clear the upper halves before a tail call into the
+     SSE2 version and leaving them dirty makes all of the SSE code
+     that runs afterwards much slower */
+  _mm256_zeroupper ();
+
+  td_sim_kernel_advance_sse2 (progress + i, y + i, step + i,
+			      n_tractors - i, start, length);
+}
+
+#endif /* TD_SIM_KERNEL_HAVE_X86 */
+
+static gboolean
+td_sim_kernel_impl_supported (TDSimKernelImpl impl)
+{
+  switch (impl)
+    {
+    case TD_SIM_KERNEL_IMPL_SCALAR:
+      return TRUE;
+
+#ifdef TD_SIM_KERNEL_HAVE_X86
+    case TD_SIM_KERNEL_IMPL_SSE2:
+      return __builtin_cpu_supports ("sse2");
+
+    case TD_SIM_KERNEL_IMPL_AVX2:
+      return __builtin_cpu_supports ("avx2");
+#endif
+
+    default:
+      return FALSE;
+    }
+}
+
+static void
+td_sim_kernel_use_impl (TDSimKernelImpl impl)
+{
+  td_sim_kernel_impl = impl;
+
+  switch (impl)
+    {
+#ifdef TD_SIM_KERNEL_HAVE_X86
+    case TD_SIM_KERNEL_IMPL_AVX2:
+      td_sim_kernel_advance_func = td_sim_kernel_advance_avx2;
+      break;
+
+    case TD_SIM_KERNEL_IMPL_SSE2:
+      td_sim_kernel_advance_func = td_sim_kernel_advance_sse2;
+      break;
+#endif
+
+    default:
+      td_sim_kernel_advance_func = td_sim_kernel_advance_scalar;
+      break;
+    }
+}
+
+static void
+td_sim_kernel_init (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      TDSimKernelImpl impl = TD_SIM_KERNEL_IMPL_AVX2;
+
+      /* Use the best version the CPU supports */
+      while (!td_sim_kernel_impl_supported (impl))
+	impl--;
+
+      td_sim_kernel_use_impl (impl);
+
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
+void
+td_sim_kernel_advance_tractors (float *progress,
+				float *y,
+				const float *step,
+				int n_tractors,
+				float start,
+				float length)
+{
+  td_sim_kernel_init ();
+
+  td_sim_kernel_advance_func (progress, y, step, n_tractors, start, length);
+}
+
+/* Overrides the implementation picked at startup. Returns FALSE if
+   the CPU doesn't support it */
+gboolean
+td_sim_kernel_set_impl (TDSimKernelImpl impl)
+{
+  td_sim_kernel_init ();
+
+  if (!td_sim_kernel_impl_supported (impl))
+    return FALSE;
+
+  td_sim_kernel_use_impl (impl);
+
+  return TRUE;
+}
+
+TDSimKernelImpl
+td_sim_kernel_get_impl (void)
+{
+  td_sim_kernel_init ();
+
+  return td_sim_kernel_impl;
+}
+
+const char *
+td_sim_kernel_get_impl_name (TDSimKernelImpl impl)
+{
+  switch (impl)
+    {
+    case TD_SIM_KERNEL_IMPL_SCALAR:
+      return "scalar";
+    case TD_SIM_KERNEL_IMPL_SSE2:
+      return "sse2";
+    case TD_SIM_KERNEL_IMPL_AVX2:
+      return "avx2";
+    }
+
+  return "unknown";
+}
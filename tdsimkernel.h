@@ -0,0 +1,53 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_SIM_KERNEL_H
+#define _HAVE_TD_SIM_KERNEL_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  TD_SIM_KERNEL_IMPL_SCALAR,
+  TD_SIM_KERNEL_IMPL_SSE2,
+  TD_SIM_KERNEL_IMPL_AVX2
+} TDSimKernelImpl;
+
+void td_sim_kernel_advance_tractors (float *progress,
+				     float *y,
+				     const float *step,
+				     int n_tractors,
+				     float start,
+				     float length);
+
+gboolean td_sim_kernel_set_impl (TDSimKernelImpl impl);
+TDSimKernelImpl td_sim_kernel_get_impl (void);
+const char *td_sim_kernel_get_impl_name (TDSimKernelImpl impl);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_SIM_KERNEL_H */
@@ -0,0 +1,136 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Generates colour variants of a skin at load time. The remap is
+   first expanded into a table giving the new hue for every degree so
+   that each texel only needs one lookup */
+
+#include <glib.h>
+#include <string.h>
+
+#include "tdskinremap.h"
+
+#define TD_SKIN_REMAP_N_HUES 360
+
+static void
+td_skin_remap_build_table (const TDSkinRemap *remap,
+			   gint16 *table)
+{
+  int i, hue;
+
+  for (hue = 0; hue < TD_SKIN_REMAP_N_HUES; hue++)
+    table[hue] = hue;
+
+  for (i = 0; i < remap->n_entries; i++)
+    {
+      const TDSkinRemapEntry *entry = remap->entries + i;
+      int offset;
+
+      for (offset = -entry->range; offset <= entry->range; offset++)
+	{
+	  int from = entry->from_hue + offset;
+	  int to = entry->to_hue + offset;
+
+	  from = ((from % TD_SKIN_REMAP_N_HUES) + TD_SKIN_REMAP_N_HUES)
+	    % TD_SKIN_REMAP_N_HUES;
+	  to = ((to % TD_SKIN_REMAP_N_HUES) + TD_SKIN_REMAP_N_HUES)
+	    % TD_SKIN_REMAP_N_HUES;
+
+	  table[from] = to;
+	}
+    }
+}
+
+/* Hue in degrees of an RGB colour whose largest and smallest
+   components are max and min */
+static int
+td_skin_remap_get_hue (int r, int g, int b, int max, int min)
+{
+  int chroma = max - min;
+  int hue;
+
+  if (max == r)
+    hue = 60 * (g - b) / chroma;
+  else if (max == g)
+    hue = 120 + 60 * (b - r) / chroma;
+  else
+    hue = 240 + 60 * (r - g) / chroma;
+
+  return hue < 0 ? hue + TD_SKIN_REMAP_N_HUES : hue;
+}
+
+/* Writes the colour with the given hue and the same largest and
+   smallest components */
+static void
+td_skin_remap_set_hue (guint8 *dst, int hue, int max, int min)
+{
+  int chroma = max - min;
+  int sector = hue / 60, rest = hue % 60;
+  int rising = min + chroma * rest / 60;
+  int falling = max - chroma * rest / 60;
+
+  switch (sector)
+    {
+    case 0: dst[0] = max; dst[1] = rising; dst[2] = min; break;
+    case 1: dst[0] = falling; dst[1] = max; dst[2] = min; break;
+    case 2: dst[0] = min; dst[1] = max; dst[2] = rising; break;
+    case 3: dst[0] = min; dst[1] = falling; dst[2] = max; break;
+    case 4: dst[0] = rising; dst[1] = min; dst[2] = max; break;
+    default: dst[0] = max; dst[1] = min; dst[2] = falling; break;
+    }
+}
+
+/* Converts n_pixels of RGBA from src into dst. They may be the same
+   buffer */
+void
+td_skin_remap_apply (const TDSkinRemap *remap,
+		     const guint8 *src,
+		     guint8 *dst,
+		     int n_pixels)
+{
+  gint16 table[TD_SKIN_REMAP_N_HUES];
+  int i;
+
+  td_skin_remap_build_table (remap, table);
+
+  for (i = 0; i < n_pixels; i++, src += 4, dst += 4)
+    {
+      int r = src[0], g = src[1], b = src[2];
+      int max = MAX (r, MAX (g, b)), min = MIN (r, MIN (g, b));
+      int hue, new_hue;
+
+      if (src != dst)
+	memcpy (dst, src, 4);
+
+      if (max == min || (max - min) * 255 < remap->min_saturation * max)
+	continue;
+
+      hue = td_skin_remap_get_hue (r, g, b, max, min);
+      new_hue = table[hue];
+
+      if (new_hue != hue)
+	td_skin_remap_set_hue (dst, new_hue, max, min);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_SKIN_REMAP_H
+#define _HAVE_TD_SKIN_REMAP_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _TDSkinRemap      TDSkinRemap;
+typedef struct _TDSkinRemapEntry TDSkinRemapEntry;
+
+/* Moves every colour whose hue is within range degrees of from_hue so
+   that from_hue lands on to_hue. Saturation and value are kept so the
+   shading painted into the skin survives */
+struct _TDSkinRemapEntry
+{
+  int from_hue, range;
+  int to_hue;
+};
+
+/* A colour variant of a skin described by a few hue moves instead of
+   a whole image. Greys below min_saturation (out of 255) are never
+   touched so the tyres and metal stay the same in every variant */
+struct _TDSkinRemap
+{
+  const char *name;
+  int min_saturation;
+  int n_entries;
+  const TDSkinRemapEntry *entries;
+};
+
+void td_skin_remap_apply (const TDSkinRemap *remap,
+			  const guint8 *src,
+			  guint8 *dst,
+			  int n_pixels);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_SKIN_REMAP_H */
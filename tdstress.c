@@ -0,0 +1,254 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Raises the number of tractors on the road step by step until the
+   frame time goes over a budget. Each step throws away the frames
+   spent settling after the new tractors were added and then collects
+   a fixed number of frame times. A step is sustainable if its 95th
+   percentile is within the budget. The percentiles of every step are
+   logged as they finish and can be written out as JSON at the end so
+   that builds can be compared */
+
+#include <glib.h>
+#include <stdlib.h>
+
+#include "tdstress.h"
+
+/* Frames to ignore after raising the count */
+#define TD_STRESS_WARMUP_FRAMES 30
+/* Frames to measure at each step */
+#define TD_STRESS_STEP_FRAMES   180
+/* Each step has this many times as many tractors as the last */
+#define TD_STRESS_GROWTH        1.25f
+/* Give up at this count even if the frame time is still good */
+#define TD_STRESS_MAX_TRACTORS  100000
+
+typedef struct _TDStressStep TDStressStep;
+
+struct _TDStressStep
+{
+  guint target;
+  /* Average number of tractors actually on the road */
+  float mean_live;
+  float p50, p95, p99, max;
+};
+
+struct _TDStress
+{
+  float budget;
+
+  guint target;
+  guint n_frames;
+  guint64 live_sum;
+  float samples[TD_STRESS_STEP_FRAMES];
+
+  /* Finished steps */
+  GArray *steps;
+  guint max_sustainable;
+  gboolean finished;
+};
+
+TDStress *
+td_stress_new (guint start_tractors, float budget_msecs)
+{
+  TDStress *stress = g_slice_new0 (TDStress);
+
+  stress->budget = budget_msecs;
+  stress->target = MAX (start_tractors, 1);
+  stress->steps = g_array_new (FALSE, FALSE, sizeof (TDStressStep));
+
+  return stress;
+}
+
+void
+td_stress_free (TDStress *stress)
+{
+  g_array_free (stress->steps, TRUE);
+
+  g_slice_free (TDStress, stress);
+}
+
+static int
+td_stress_compare_float (gconstpointer a, gconstpointer b)
+{
+  float fa = *(const float *) a, fb = *(const float *) b;
+
+  return fa < fb ? -1 : fa > fb ? 1 : 0;
+}
+
+/* Nearest rank percentile of sorted samples */
+static float
+td_stress_percentile (const float *samples, guint n_samples, int percent)
+{
+  guint rank = (n_samples * percent + 99) / 100;
+
+  return samples[MAX (rank, 1) - 1];
+}
+
+static void
+td_stress_finish_step (TDStress *stress)
+{
+  TDStressStep step;
+  guint next;
+
+  qsort (stress->samples, TD_STRESS_STEP_FRAMES, sizeof (float),
+	 td_stress_compare_float);
+
+  step.target = stress->target;
+  step.mean_live = stress->live_sum / (float) TD_STRESS_STEP_FRAMES;
+  step.p50 = td_stress_percentile (stress->samples, TD_STRESS_STEP_FRAMES, 50);
+  step.p95 = td_stress_percentile (stress->samples, TD_STRESS_STEP_FRAMES, 95);
+  step.p99 = td_stress_percentile (stress->samples, TD_STRESS_STEP_FRAMES, 99);
+  step.max = stress->samples[TD_STRESS_STEP_FRAMES - 1];
+  g_array_append_val (stress->steps, step);
+
+  g_print ("stress: %6u tractors: p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, "
+	   "max %.2f ms\n",
+	   step.target, step.p50, step.p95, step.p99, step.max);
+
+  if (step.p95 > stress->budget)
+    {
+      stress->finished = TRUE;
+      return;
+    }
+
+  stress->max_sustainable = step.target;
+
+  next = MAX (stress->target * TD_STRESS_GROWTH, stress->target + 1);
+
+  if (next > TD_STRESS_MAX_TRACTORS)
+    stress->finished = TRUE;
+  else
+    stress->target = next;
+}
+
+/* Adds the time taken by a frame and how many tractors were drawn in
+   it. Returns TRUE when this finishes a step so the target might have
+   changed */
+gboolean
+td_stress_add_frame (TDStress *stress, float msecs, guint n_live_tractors)
+{
+  guint frame;
+
+  if (stress->finished)
+    return FALSE;
+
+  frame = stress->n_frames++;
+
+  if (frame < TD_STRESS_WARMUP_FRAMES)
+    return FALSE;
+
+  frame -= TD_STRESS_WARMUP_FRAMES;
+  stress->samples[frame] = msecs;
+  stress->live_sum += n_live_tractors;
+
+  if (frame + 1 < TD_STRESS_STEP_FRAMES)
+    return FALSE;
+
+  td_stress_finish_step (stress);
+
+  stress->n_frames = 0;
+  stress->live_sum = 0;
+
+  return TRUE;
+}
+
+/* Gets the number of tractors that should be on the road */
+guint
+td_stress_get_target (TDStress *stress)
+{
+  return stress->target;
+}
+
+gboolean
+td_stress_is_finished (TDStress *stress)
+{
+  return stress->finished;
+}
+
+/* Gets the highest count that stayed within the budget or zero if
+   even the first step went over */
+guint
+td_stress_get_max_sustainable (TDStress *stress)
+{
+  return stress->max_sustainable;
+}
+
+static void
+td_stress_append_float (GString *str, const char *name, float value)
+{
+  char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  /* Always use a dot whatever the locale */
+  g_string_append_printf (str, "\"%s\": %s", name,
+			  g_ascii_formatd (buf, sizeof (buf), "%.3f", value));
+}
+
+gboolean
+td_stress_write_report (TDStress *stress,
+			const char *filename,
+			GError **error)
+{
+  GString *str = g_string_new (NULL);
+  gboolean ret;
+  guint i;
+
+  g_string_append (str, "{\n  ");
+  td_stress_append_float (str, "budget_ms", stress->budget);
+  g_string_append_printf (str, ",\n"
+			  "  \"warmup_frames\": %i,\n"
+			  "  \"frames_per_step\": %i,\n"
+			  "  \"max_sustainable_tractors\": %u,\n"
+			  "  \"steps\": [",
+			  TD_STRESS_WARMUP_FRAMES, TD_STRESS_STEP_FRAMES,
+			  stress->max_sustainable);
+
+  for (i = 0; i < stress->steps->len; i++)
+    {
+      const TDStressStep *step = &g_array_index (stress->steps,
+						 TDStressStep, i);
+
+      g_string_append_printf (str, "%s\n    { \"tractors\": %u, ",
+			      i > 0 ? "," : "", step->target);
+      td_stress_append_float (str, "mean_live", step->mean_live);
+      g_string_append (str, ", ");
+      td_stress_append_float (str, "p50_ms", step->p50);
+      g_string_append (str, ", ");
+      td_stress_append_float (str, "p95_ms", step->p95);
+      g_string_append (str, ", ");
+      td_stress_append_float (str, "p99_ms", step->p99);
+      g_string_append (str, ", ");
+      td_stress_append_float (str, "max_ms", step->max);
+      g_string_append (str, " }");
+    }
+
+  g_string_append (str, "\n  ]\n}\n");
+
+  ret = g_file_set_contents (filename, str->str, str->len, error);
+
+  g_string_free (str, TRUE);
+
+  return ret;
+}
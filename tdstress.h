@@ -0,0 +1,52 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_STRESS_H
+#define _HAVE_TD_STRESS_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _TDStress TDStress;
+
+TDStress *td_stress_new (guint start_tractors, float budget_msecs);
+void td_stress_free (TDStress *stress);
+
+gboolean td_stress_add_frame (TDStress *stress,
+			      float msecs,
+			      guint n_live_tractors);
+
+guint td_stress_get_target (TDStress *stress);
+gboolean td_stress_is_finished (TDStress *stress);
+guint td_stress_get_max_sustainable (TDStress *stress);
+
+gboolean td_stress_write_report (TDStress *stress,
+				 const char *filename,
+				 GError **error);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_STRESS_H */
@@ -0,0 +1,193 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <glib.h>
+
+#include "tdtimerwheel.h"
+
+/* A hashed timing wheel counted in simulation ticks. Each slot holds
+   the timers that expire on a tick that maps to it along with the
+   number of times the wheel has to go round before they are due, so
+   adding a timer and advancing the wheel don't depend on how many
+   timers are pending */
+
+typedef struct _TDTimerWheelTimer TDTimerWheelTimer;
+
+struct _TDTimerWheelTimer
+{
+  guint rounds;
+  gpointer data;
+
+  TDTimerWheelTimer *next;
+};
+
+struct _TDTimerWheel
+{
+  guint n_slots;
+  guint current_slot;
+  TDTimerWheelTimer **slots;
+
+  /* Timers that have expired and can be reused without allocating */
+  TDTimerWheelTimer *free_timers;
+
+  guint n_timers;
+};
+
+TDTimerWheel *
+td_timer_wheel_new (guint n_slots)
+{
+  TDTimerWheel *wheel = g_slice_new (TDTimerWheel);
+
+  wheel->n_slots = MAX (n_slots, 1);
+  wheel->current_slot = 0;
+  wheel->slots = g_new0 (TDTimerWheelTimer *, wheel->n_slots);
+  wheel->free_timers = NULL;
+  wheel->n_timers = 0;
+
+  return wheel;
+}
+
+static void
+td_timer_wheel_free_list (TDTimerWheelTimer *timer)
+{
+  while (timer)
+    {
+      TDTimerWheelTimer *next = timer->next;
+
+      g_slice_free (TDTimerWheelTimer, timer);
+      timer = next;
+    }
+}
+
+void
+td_timer_wheel_free (TDTimerWheel *wheel)
+{
+  guint i;
+
+  for (i = 0; i < wheel->n_slots; i++)
+    td_timer_wheel_free_list (wheel->slots[i]);
+  td_timer_wheel_free_list (wheel->free_timers);
+
+  g_free (wheel->slots);
+
+  g_slice_free (TDTimerWheel, wheel);
+}
+
+/* Removes all of the pending timers without calling them */
+void
+td_timer_wheel_clear (TDTimerWheel *wheel)
+{
+  guint i;
+
+  for (i = 0; i < wheel->n_slots; i++)
+    while (wheel->slots[i])
+      {
+	TDTimerWheelTimer *timer = wheel->slots[i];
+
+	wheel->slots[i] = timer->next;
+	timer->next = wheel->free_timers;
+	wheel->free_timers = timer;
+      }
+
+  wheel->n_timers = 0;
+}
+
+/* Adds a timer that will be passed to the callback on the n_ticks'th
+   call to td_timer_wheel_advance from now. A timer always waits for
+   at least one tick */
+void
+td_timer_wheel_add (TDTimerWheel *wheel, guint n_ticks, gpointer data)
+{
+  TDTimerWheelTimer *timer;
+  guint slot;
+
+  n_ticks = MAX (n_ticks, 1);
+
+  if ((timer = wheel->free_timers))
+    wheel->free_timers = timer->next;
+  else
+    timer = g_slice_new (TDTimerWheelTimer);
+
+  /* The slot is first reached after (n_ticks - 1) % n_slots + 1
+     ticks and then again every n_slots ticks */
+  slot = (wheel->current_slot + n_ticks) % wheel->n_slots;
+  timer->rounds = (n_ticks - 1) / wheel->n_slots;
+  timer->data = data;
+
+  timer->next = wheel->slots[slot];
+  wheel->slots[slot] = timer;
+
+  wheel->n_timers++;
+}
+
+/* Moves the wheel on by one tick and calls func for each timer that
+   expires in the order that they were added */
+void
+td_timer_wheel_advance (TDTimerWheel *wheel,
+			TDTimerWheelFunc func,
+			gpointer user_data)
+{
+  TDTimerWheelTimer **prev, *timer, *expired = NULL;
+
+  wheel->current_slot = (wheel->current_slot + 1) % wheel->n_slots;
+
+  /* Unlink the expired timers first so that the callbacks can add
+     new ones */
+  prev = wheel->slots + wheel->current_slot;
+  while ((timer = *prev))
+    {
+      if (timer->rounds == 0)
+	{
+	  *prev = timer->next;
+	  timer->next = expired;
+	  expired = timer;
+	  wheel->n_timers--;
+	}
+      else
+	{
+	  timer->rounds--;
+	  prev = &timer->next;
+	}
+    }
+
+  /* The slot is in reverse order of adding and unlinking reversed it
+     again */
+  while ((timer = expired))
+    {
+      gpointer data = timer->data;
+
+      expired = timer->next;
+      timer->next = wheel->free_timers;
+      wheel->free_timers = timer;
+
+      func (data, user_data);
+    }
+}
+
+guint
+td_timer_wheel_get_n_timers (TDTimerWheel *wheel)
+{
+  return wheel->n_timers;
+}
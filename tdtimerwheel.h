@@ -0,0 +1,51 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_TIMER_WHEEL_H
+#define _HAVE_TD_TIMER_WHEEL_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _TDTimerWheel TDTimerWheel;
+
+typedef void (* TDTimerWheelFunc) (gpointer data, gpointer user_data);
+
+TDTimerWheel *td_timer_wheel_new (guint n_slots);
+void td_timer_wheel_free (TDTimerWheel *wheel);
+
+void td_timer_wheel_clear (TDTimerWheel *wheel);
+
+void td_timer_wheel_add (TDTimerWheel *wheel, guint n_ticks, gpointer data);
+void td_timer_wheel_advance (TDTimerWheel *wheel,
+			     TDTimerWheelFunc func,
+			     gpointer user_data);
+
+guint td_timer_wheel_get_n_timers (TDTimerWheel *wheel);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_TIMER_WHEEL_H */
@@ -0,0 +1,742 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <clutter/clutter-actor.h>
+#include <cogl/cogl.h>
+#ifdef HAVE_COGL_GL
+#include <GL/gl.h>
+#endif
+#include <string.h>
+
+#include "tdtractorlayer.h"
+#include "tdprofiler.h"
+
+/* Draws every tractor on the road from a single actor. The tractors
+   are sorted by skin and all of the tractors sharing a skin are drawn
+   with one glDrawArrays so the number of draw calls only depends on
+   the number of skins. GL 1.x has no instancing so each tractor's
+   transform is applied to its vertices on the CPU while filling the
+   batch.
+
+   Before sorting, the box around each tractor is projected with the
+   current GL matrices. Tractors entirely outside of the view aren't
+   drawn at all and ones that only cover a few pixels in the distance
+   are batched separately at a cheaper level of detail.
+
+   GLES has no attribute stack and can't read back the matrices so
+   there each triangle is drawn with cogl_texture_polygon instead and
+   every tractor is drawn at full detail */
+
+#define TD_TRACTOR_LAYER_GET_PRIVATE(obj) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj), TD_TYPE_TRACTOR_LAYER, \
+				TDTractorLayerPrivate))
+
+G_DEFINE_TYPE (TDTractorLayer, td_tractor_layer, CLUTTER_TYPE_ACTOR)
+
+/* Tractors that are projected narrower than lod_widths[i] pixels are
+   drawn with level i + 1 */
+static const float lod_widths[TD_TRACTOR_LAYER_N_LEVELS - 1] =
+  { 72.0f, 48.0f };
+
+/* Sort key of tractors that aren't drawn */
+#define TD_TRACTOR_LAYER_CULLED     G_MAXUINT
+
+static void td_tractor_layer_paint (ClutterActor *self);
+static void td_tractor_layer_dispose (GObject *self);
+static void td_tractor_layer_finalize (GObject *self);
+
+typedef struct _TDTractorLayerLevel TDTractorLayerLevel;
+
+struct _TDTractorLayerLevel
+{
+  TDModel *model;
+  /* Always draw the first keyframe instead of the tractor's own */
+  gboolean frozen;
+
+  /* The model's texture coordinates repeated once per tractor */
+  float *tex_coords;
+  guint tex_coords_size;
+};
+
+struct _TDTractorLayerPrivate
+{
+  TDModel *model;
+  TDTractorLayerLevel levels[TD_TRACTOR_LAYER_N_LEVELS];
+
+  int tractor_size;
+  /* Scale from model units to pixels and the center of the model */
+  float scale, center[3];
+
+  CoglHandle *textures;
+#ifdef HAVE_COGL_GL
+  /* The GL texture for each skin or 0 if it can't be used directly */
+  GLuint *gl_textures;
+#endif
+
+  /* A copy of the simulation's tractors from the last update */
+  guint n_tractors, tractors_size;
+  float *x, *y;
+  int *skin, *frame;
+
+  /* Batch of each tractor, made from its level and skin */
+  guint *batch;
+  /* Indices of the drawn tractors sorted by batch. batch_start has an
+     extra entry so batch_start[batch + 1] is always the end of a
+     batch */
+  guint *order;
+  guint *batch_start;
+
+  /* Room for the vertices of the biggest batch */
+  float *vertices;
+  guint vertices_size;
+
+  /* Counts for the last paint */
+  guint n_draw_calls, n_culled, n_lod;
+
+  guint n_paints;
+  guint64 total_draw_calls, total_culled, total_lod;
+  guint max_tractors;
+};
+
+static void
+td_tractor_layer_class_init (TDTractorLayerClass *klass)
+{
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  actor_class->paint = td_tractor_layer_paint;
+
+  object_class->dispose = td_tractor_layer_dispose;
+  object_class->finalize = td_tractor_layer_finalize;
+
+  g_type_class_add_private (klass, sizeof (TDTractorLayerPrivate));
+}
+
+static void
+td_tractor_layer_init (TDTractorLayer *self)
+{
+  self->priv = TD_TRACTOR_LAYER_GET_PRIVATE (self);
+}
+
+ClutterActor *
+td_tractor_layer_new (TDModel *model, int tractor_size)
+{
+  TDTractorLayer *self = g_object_new (TD_TYPE_TRACTOR_LAYER, NULL);
+  TDTractorLayerPrivate *priv = self->priv;
+  float extent;
+  int i;
+
+  priv->model = td_model_ref (model);
+  priv->tractor_size = tractor_size;
+
+  /* Unless simpler meshes are set the far tractors at least stop
+     animating */
+  for (i = 0; i < TD_TRACTOR_LAYER_N_LEVELS; i++)
+    {
+      priv->levels[i].model = td_model_ref (model);
+      priv->levels[i].frozen = i > 0;
+    }
+
+  /* Fit the model into the square the same way ClutterMD2 does */
+  extent = MAX (model->max[0] - model->min[0], model->max[1] - model->min[1]);
+  priv->scale = extent > 0.0f ? tractor_size / extent : 0.0f;
+  for (i = 0; i < 3; i++)
+    priv->center[i] = (model->min[i] + model->max[i]) / 2.0f;
+
+  priv->textures = g_new (CoglHandle, model->n_skins);
+#ifdef HAVE_COGL_GL
+  priv->gl_textures = g_new0 (GLuint, model->n_skins);
+#endif
+  for (i = 0; i < model->n_skins; i++)
+    {
+#ifdef HAVE_COGL_GL
+      GLuint gl_tex;
+      GLenum gl_target;
+#endif
+
+      priv->textures[i]
+	= cogl_texture_new_from_data (model->skin_width,
+				      model->skin_height,
+				      -1,
+				      TRUE,
+				      COGL_PIXEL_FORMAT_RGBA_8888,
+				      COGL_PIXEL_FORMAT_RGBA_8888,
+				      model->skin_width * 4,
+				      model->skins[i]);
+
+#ifdef HAVE_COGL_GL
+      if (priv->textures[i] != COGL_INVALID_HANDLE
+	  && cogl_texture_get_gl_texture (priv->textures[i],
+					  &gl_tex, &gl_target)
+	  && gl_target == GL_TEXTURE_2D)
+	priv->gl_textures[i] = gl_tex;
+#endif
+    }
+
+  priv->batch_start = g_new0 (guint, (MAX (model->n_skins, 1)
+				      * TD_TRACTOR_LAYER_N_LEVELS + 1));
+
+  return CLUTTER_ACTOR (self);
+}
+
+/* Copies the state of the tractors from the simulation. This should
+   be called whenever the simulation has advanced */
+void
+td_tractor_layer_set_tractors (TDTractorLayer *layer,
+			       const TDSimTractors *tractors)
+{
+  TDTractorLayerPrivate *priv;
+  guint n = tractors->n_tractors;
+
+  g_return_if_fail (TD_IS_TRACTOR_LAYER (layer));
+
+  priv = layer->priv;
+
+  if (n > priv->tractors_size)
+    {
+      priv->tractors_size = MAX (priv->tractors_size * 2, n);
+      priv->x = g_renew (float, priv->x, priv->tractors_size);
+      priv->y = g_renew (float, priv->y, priv->tractors_size);
+      priv->skin = g_renew (int, priv->skin, priv->tractors_size);
+      priv->frame = g_renew (int, priv->frame, priv->tractors_size);
+      priv->batch = g_renew (guint, priv->batch, priv->tractors_size);
+      priv->order = g_renew (guint, priv->order, priv->tractors_size);
+    }
+
+  memcpy (priv->x, tractors->x, n * sizeof (float));
+  memcpy (priv->y, tractors->y, n * sizeof (float));
+  memcpy (priv->skin, tractors->skin, n * sizeof (int));
+  memcpy (priv->frame, tractors->frame, n * sizeof (int));
+  priv->n_tractors = n;
+
+  priv->max_tractors = MAX (priv->max_tractors, n);
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (layer));
+}
+
+/* Replaces the mesh used for the given level of detail. The model
+   should be a simpler version of the layer's model made to be drawn
+   with the same skins */
+void
+td_tractor_layer_set_lod_model (TDTractorLayer *layer,
+				int level,
+				TDModel *model)
+{
+  TDTractorLayerLevel *lod;
+
+  g_return_if_fail (TD_IS_TRACTOR_LAYER (layer));
+  g_return_if_fail (level > 0 && level < TD_TRACTOR_LAYER_N_LEVELS);
+
+  lod = layer->priv->levels + level;
+
+  td_model_ref (model);
+  td_model_unref (lod->model);
+  lod->model = model;
+  lod->frozen = FALSE;
+
+  g_free (lod->tex_coords);
+  lod->tex_coords = NULL;
+  lod->tex_coords_size = 0;
+
+  /* The vertex buffer may need to grow */
+  g_free (layer->priv->vertices);
+  layer->priv->vertices = NULL;
+  layer->priv->vertices_size = 0;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (layer));
+}
+
+#ifdef HAVE_COGL_GL
+
+/* Transforms x, y, z by the column major matrix into clip
+   coordinates */
+static void
+td_tractor_layer_project (const float *matrix,
+			  float x, float y, float z,
+			  float *clip)
+{
+  int i;
+
+  for (i = 0; i < 4; i++)
+    clip[i] = (matrix[i] * x + matrix[i + 4] * y + matrix[i + 8] * z
+	       + matrix[i + 12]);
+}
+
+/* Gets the outside bits of a clip space point for each of the six
+   planes of the view */
+static guint
+td_tractor_layer_get_outcode (const float *clip)
+{
+  return ((clip[0] < -clip[3])
+	  | ((clip[0] > clip[3]) << 1)
+	  | ((clip[1] < -clip[3]) << 2)
+	  | ((clip[1] > clip[3]) << 3)
+	  | ((clip[2] < -clip[3]) << 4)
+	  | ((clip[2] > clip[3]) << 5));
+}
+
+/* Works out which batch each tractor belongs to using the matrices
+   that the layer is about to be painted with */
+static void
+td_tractor_layer_classify (TDTractorLayerPrivate *priv)
+{
+  const TDModel *model = priv->model;
+  int n_skins = MAX (model->n_skins, 1);
+  float modelview[16], projection[16], matrix[16];
+  GLint viewport[4];
+  float size = priv->tractor_size;
+  float z_min = (model->min[2] - priv->center[2]) * priv->scale;
+  float z_max = (model->max[2] - priv->center[2]) * priv->scale;
+  guint i;
+  int row, col, k;
+
+  glGetFloatv (GL_MODELVIEW_MATRIX, modelview);
+  glGetFloatv (GL_PROJECTION_MATRIX, projection);
+  glGetIntegerv (GL_VIEWPORT, viewport);
+
+  for (col = 0; col < 4; col++)
+    for (row = 0; row < 4; row++)
+      {
+	float sum = 0.0f;
+
+	for (k = 0; k < 4; k++)
+	  sum += projection[k * 4 + row] * modelview[col * 4 + k];
+
+	matrix[col * 4 + row] = sum;
+      }
+
+  for (i = 0; i < priv->n_tractors; i++)
+    {
+      float x = priv->x[i], y = priv->y[i];
+      float clip[4], left[4], right[4], width;
+      guint outcode = ~0U;
+      int level = 0;
+
+      /* A tractor can only be skipped if every corner of its box is
+	 outside of the same plane */
+      for (k = 0; k < 8 && outcode; k++)
+	{
+	  td_tractor_layer_project (matrix,
+				    x + ((k & 1) ? size : 0.0f),
+				    y + ((k & 2) ? size : 0.0f),
+				    (k & 4) ? z_max : z_min,
+				    clip);
+	  outcode &= td_tractor_layer_get_outcode (clip);
+	}
+
+      if (outcode)
+	{
+	  priv->batch[i] = TD_TRACTOR_LAYER_CULLED;
+	  priv->n_culled++;
+	  continue;
+	}
+
+      /* Measure how wide the middle of the tractor is on the screen */
+      td_tractor_layer_project (matrix, x, y + size / 2.0f, 0.0f, left);
+      td_tractor_layer_project (matrix, x + size, y + size / 2.0f, 0.0f,
+				right);
+      if (left[3] > 0.0f && right[3] > 0.0f)
+	{
+	  width = (ABS (right[0] / right[3] - left[0] / left[3])
+		   * viewport[2] / 2.0f);
+
+	  while (level < TD_TRACTOR_LAYER_N_LEVELS - 1
+		 && width < lod_widths[level])
+	    level++;
+
+	  if (level > 0)
+	    priv->n_lod++;
+	}
+
+      priv->batch[i] = level * n_skins + CLAMP (priv->skin[i], 0, n_skins - 1);
+    }
+}
+
+#else /* HAVE_COGL_GL */
+
+/* Without the matrices nothing can be culled so each tractor is just
+   batched by its skin at the first level */
+static void
+td_tractor_layer_classify (TDTractorLayerPrivate *priv)
+{
+  int n_skins = MAX (priv->model->n_skins, 1);
+  guint i;
+
+  for (i = 0; i < priv->n_tractors; i++)
+    priv->batch[i] = CLAMP (priv->skin[i], 0, n_skins - 1);
+}
+
+#endif /* HAVE_COGL_GL */
+
+/* Sorts the indices of the drawn tractors by batch with a counting
+   sort. Returns the size of the biggest batch */
+static guint
+td_tractor_layer_sort (TDTractorLayerPrivate *priv)
+{
+  int n_batches = MAX (priv->model->n_skins, 1) * TD_TRACTOR_LAYER_N_LEVELS;
+  guint *fill = g_alloca (sizeof (guint) * n_batches);
+  guint i, biggest = 0;
+  int batch;
+
+  memset (priv->batch_start, 0, sizeof (guint) * (n_batches + 1));
+  for (i = 0; i < priv->n_tractors; i++)
+    if (priv->batch[i] != TD_TRACTOR_LAYER_CULLED)
+      priv->batch_start[priv->batch[i] + 1]++;
+
+  for (batch = 0; batch < n_batches; batch++)
+    {
+      biggest = MAX (biggest, priv->batch_start[batch + 1]);
+      priv->batch_start[batch + 1] += priv->batch_start[batch];
+      fill[batch] = priv->batch_start[batch];
+    }
+
+  for (i = 0; i < priv->n_tractors; i++)
+    if (priv->batch[i] != TD_TRACTOR_LAYER_CULLED)
+      priv->order[fill[priv->batch[i]]++] = i;
+
+  return biggest;
+}
+
+static void
+td_tractor_layer_ensure_buffers (TDTractorLayerPrivate *priv,
+				 guint n_instances)
+{
+  int n_vertices = 0;
+  int level;
+  guint i;
+
+  for (level = 0; level < TD_TRACTOR_LAYER_N_LEVELS; level++)
+    n_vertices = MAX (n_vertices, priv->levels[level].model->n_vertices);
+
+  if (n_instances > priv->vertices_size)
+    {
+      priv->vertices_size = MAX (priv->vertices_size * 2, n_instances);
+      g_free (priv->vertices);
+      priv->vertices = g_new (float, priv->vertices_size * n_vertices * 3);
+    }
+
+  for (level = 0; level < TD_TRACTOR_LAYER_N_LEVELS; level++)
+    {
+      TDTractorLayerLevel *lod = priv->levels + level;
+      const TDModel *model = lod->model;
+      guint old_size = lod->tex_coords_size;
+
+      if (n_instances <= lod->tex_coords_size)
+	continue;
+
+      lod->tex_coords_size = MAX (lod->tex_coords_size * 2, n_instances);
+      lod->tex_coords = g_renew (float, lod->tex_coords,
+				 lod->tex_coords_size * model->n_vertices * 2);
+
+      for (i = old_size; i < lod->tex_coords_size; i++)
+	memcpy (lod->tex_coords + i * model->n_vertices * 2,
+		model->tex_coords,
+		model->n_vertices * 2 * sizeof (float));
+    }
+}
+
+/* Writes the vertices of one tractor turned around to face the car
+   with its top left corner at x, y */
+static float *
+td_tractor_layer_add_instance (TDTractorLayerPrivate *priv,
+			       const TDTractorLayerLevel *lod,
+			       guint index,
+			       float *out)
+{
+  const TDModel *model = lod->model;
+  const float *v;
+  float half_size = priv->tractor_size / 2.0f;
+  float scale = priv->scale;
+  /* Rotating by 180 degrees flips both of the axes and the model's Y
+     axis already points up the screen */
+  float ox = priv->x[index] + half_size + priv->center[0] * scale;
+  float oy = priv->y[index] + half_size - priv->center[1] * scale;
+  float oz = -priv->center[2] * scale;
+  int i;
+
+  if (lod->frozen)
+    v = td_model_get_frame (model, 0);
+  else
+    v = td_model_get_frame (model, priv->frame[index]);
+
+  for (i = 0; i < model->n_vertices; i++, v += 3)
+    {
+      *(out++) = ox - v[0] * scale;
+      *(out++) = oy + v[1] * scale;
+      *(out++) = oz + v[2] * scale;
+    }
+
+  return out;
+}
+
+#ifdef HAVE_COGL_GL
+
+/* Draws the batch filled into the vertices with the skin and returns
+   the number of draw calls used */
+static guint
+td_tractor_layer_draw_batch (TDTractorLayerPrivate *priv,
+			     const TDTractorLayerLevel *lod,
+			     int skin,
+			     guint n_instances)
+{
+  if (skin < priv->model->n_skins && priv->gl_textures[skin])
+    {
+      glEnable (GL_TEXTURE_2D);
+      glBindTexture (GL_TEXTURE_2D, priv->gl_textures[skin]);
+      glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+      glTexCoordPointer (2, GL_FLOAT, 0, lod->tex_coords);
+    }
+  else
+    {
+      glDisable (GL_TEXTURE_2D);
+      glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+    }
+
+  glDrawArrays (GL_TRIANGLES, 0, n_instances * lod->model->n_vertices);
+
+  return 1;
+}
+
+#else /* HAVE_COGL_GL */
+
+static guint
+td_tractor_layer_draw_batch (TDTractorLayerPrivate *priv,
+			     const TDTractorLayerLevel *lod,
+			     int skin,
+			     guint n_instances)
+{
+  guint n_triangles = n_instances * lod->model->n_vertices / 3;
+  const float *v = priv->vertices, *tex_coord = lod->tex_coords;
+  CoglTextureVertex triangle[3];
+  guint i;
+  int k;
+
+  /* Cogl can only draw textured polygons so tractors without a skin
+     are left out */
+  if (skin >= priv->model->n_skins
+      || priv->textures[skin] == COGL_INVALID_HANDLE)
+    return 0;
+
+  memset (triangle, 0, sizeof (triangle));
+
+  for (i = 0; i < n_triangles; i++)
+    {
+      for (k = 0; k < 3; k++, v += 3, tex_coord += 2)
+	{
+	  triangle[k].x = CLUTTER_FLOAT_TO_FIXED (v[0]);
+	  triangle[k].y = CLUTTER_FLOAT_TO_FIXED (v[1]);
+	  triangle[k].z = CLUTTER_FLOAT_TO_FIXED (v[2]);
+	  triangle[k].tx = CLUTTER_FLOAT_TO_FIXED (tex_coord[0]);
+	  triangle[k].ty = CLUTTER_FLOAT_TO_FIXED (tex_coord[1]);
+	}
+
+      cogl_texture_polygon (priv->textures[skin], 3, triangle, FALSE);
+    }
+
+  return n_triangles;
+}
+
+#endif /* HAVE_COGL_GL */
+
+static void
+td_tractor_layer_do_paint (ClutterActor *self)
+{
+  TDTractorLayerPrivate *priv = TD_TRACTOR_LAYER (self)->priv;
+  ClutterColor color = { 0xff, 0xff, 0xff, 0xff };
+  int n_skins = MAX (priv->model->n_skins, 1);
+  int batch;
+  guint i;
+
+  priv->n_draw_calls = 0;
+  priv->n_culled = 0;
+  priv->n_lod = 0;
+  priv->n_paints++;
+
+  if (priv->n_tractors == 0 || priv->scale <= 0.0f)
+    return;
+
+  td_tractor_layer_classify (priv);
+  td_tractor_layer_ensure_buffers (priv, td_tractor_layer_sort (priv));
+
+  priv->total_culled += priv->n_culled;
+  priv->total_lod += priv->n_lod;
+
+  color.alpha = clutter_actor_get_paint_opacity (self);
+  cogl_color (&color);
+
+#ifdef HAVE_COGL_GL
+  glPushAttrib (GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_DEPTH_BUFFER_BIT
+		| GL_COLOR_BUFFER_BIT);
+  glPushClientAttrib (GL_CLIENT_VERTEX_ARRAY_BIT);
+
+  glEnable (GL_DEPTH_TEST);
+  glDepthFunc (GL_LEQUAL);
+
+  if (color.alpha < 0xff)
+    {
+      glEnable (GL_BLEND);
+      glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+  else
+    glDisable (GL_BLEND);
+
+  glEnableClientState (GL_VERTEX_ARRAY);
+  glDisableClientState (GL_COLOR_ARRAY);
+  glVertexPointer (3, GL_FLOAT, 0, priv->vertices);
+#else
+  cogl_enable_depth_test (TRUE);
+#endif
+
+  for (batch = 0; batch < n_skins * TD_TRACTOR_LAYER_N_LEVELS; batch++)
+    {
+      guint start = priv->batch_start[batch];
+      guint end = priv->batch_start[batch + 1];
+      const TDTractorLayerLevel *lod = priv->levels + batch / n_skins;
+      int skin = batch % n_skins;
+      float *out = priv->vertices;
+
+      if (start == end)
+	continue;
+
+      for (i = start; i < end; i++)
+	out = td_tractor_layer_add_instance (priv, lod, priv->order[i], out);
+
+      priv->n_draw_calls += td_tractor_layer_draw_batch (priv, lod, skin,
+							 end - start);
+    }
+
+#ifdef HAVE_COGL_GL
+  glPopClientAttrib ();
+  glPopAttrib ();
+#else
+  cogl_enable_depth_test (FALSE);
+#endif
+
+  priv->total_draw_calls += priv->n_draw_calls;
+}
+
+static void
+td_tractor_layer_paint (ClutterActor *self)
+{
+  TDProfilerScope scope;
+
+  td_profiler_begin (&scope, TD_PROFILER_PHASE_PAINT_TRACTORS);
+  td_tractor_layer_do_paint (self);
+  td_profiler_end (&scope);
+}
+
+/* Gets the number of draw calls used by the last paint */
+guint
+td_tractor_layer_get_n_draw_calls (TDTractorLayer *layer)
+{
+  g_return_val_if_fail (TD_IS_TRACTOR_LAYER (layer), 0);
+
+  return layer->priv->n_draw_calls;
+}
+
+/* Gets the number of tractors that were skipped for being out of
+   view and the number drawn with a lower level of detail in the last
+   paint */
+void
+td_tractor_layer_get_n_culled (TDTractorLayer *layer,
+			       guint *n_culled,
+			       guint *n_lod)
+{
+  g_return_if_fail (TD_IS_TRACTOR_LAYER (layer));
+
+  if (n_culled)
+    *n_culled = layer->priv->n_culled;
+  if (n_lod)
+    *n_lod = layer->priv->n_lod;
+}
+
+void
+td_tractor_layer_get_stats (TDTractorLayer *layer,
+			    guint *n_paints,
+			    guint64 *n_draw_calls,
+			    guint64 *n_culled,
+			    guint64 *n_lod,
+			    guint *max_tractors)
+{
+  g_return_if_fail (TD_IS_TRACTOR_LAYER (layer));
+
+  if (n_paints)
+    *n_paints = layer->priv->n_paints;
+  if (n_draw_calls)
+    *n_draw_calls = layer->priv->total_draw_calls;
+  if (n_culled)
+    *n_culled = layer->priv->total_culled;
+  if (n_lod)
+    *n_lod = layer->priv->total_lod;
+  if (max_tractors)
+    *max_tractors = layer->priv->max_tractors;
+}
+
+static void
+td_tractor_layer_dispose (GObject *self)
+{
+  TDTractorLayerPrivate *priv = TD_TRACTOR_LAYER (self)->priv;
+  int i;
+
+  if (priv->model)
+    {
+      for (i = 0; i < priv->model->n_skins; i++)
+	if (priv->textures[i] != COGL_INVALID_HANDLE)
+	  cogl_texture_unref (priv->textures[i]);
+
+      for (i = 0; i < TD_TRACTOR_LAYER_N_LEVELS; i++)
+	td_model_unref (priv->levels[i].model);
+
+      td_model_unref (priv->model);
+      priv->model = NULL;
+    }
+
+  G_OBJECT_CLASS (td_tractor_layer_parent_class)->dispose (self);
+}
+
+static void
+td_tractor_layer_finalize (GObject *self)
+{
+  TDTractorLayerPrivate *priv = TD_TRACTOR_LAYER (self)->priv;
+  int i;
+
+  for (i = 0; i < TD_TRACTOR_LAYER_N_LEVELS; i++)
+    g_free (priv->levels[i].tex_coords);
+
+  g_free (priv->textures);
+#ifdef HAVE_COGL_GL
+  g_free (priv->gl_textures);
+#endif
+  g_free (priv->x);
+  g_free (priv->y);
+  g_free (priv->skin);
+  g_free (priv->frame);
+  g_free (priv->batch);
+  g_free (priv->order);
+  g_free (priv->batch_start);
+  g_free (priv->vertices);
+
+  G_OBJECT_CLASS (td_tractor_layer_parent_class)->finalize (self);
+}
@@ -0,0 +1,97 @@
+/*
+ * tractordodge
+ *
+ * A sample game for the ClutterMD2 renderer
+ *
+ * Authored By Neil Roberts  <neil@o-hand.com>
+ *
+ * Copyright (C) 2008 OpenedHand
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _HAVE_TD_TRACTOR_LAYER_H
+#define _HAVE_TD_TRACTOR_LAYER_H
+
+#include <glib-object.h>
+#include <clutter/clutter-actor.h>
+
+#include "tdmodel.h"
+#include "tdsim.h"
+
+G_BEGIN_DECLS
+
+#define TD_TYPE_TRACTOR_LAYER      (td_tractor_layer_get_type ())
+
+/* Number of levels of detail. Level 0 is used for the nearest
+   tractors */
+#define TD_TRACTOR_LAYER_N_LEVELS  3
+
+#define TD_TRACTOR_LAYER(obj)						\
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), TD_TYPE_TRACTOR_LAYER, TDTractorLayer))
+#define TD_TRACTOR_LAYER_CLASS(klass)					\
+  (G_TYPE_CHECK_CLASS_CAST ((klass), TD_TYPE_TRACTOR_LAYER, TDTractorLayerClass))
+#define TD_IS_TRACTOR_LAYER(obj)					\
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), TD_TYPE_TRACTOR_LAYER))
+#define TD_IS_TRACTOR_LAYER_CLASS(klass)				\
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), TD_TYPE_TRACTOR_LAYER))
+#define TD_TRACTOR_LAYER_GET_CLASS(obj)					\
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), TD_TYPE_TRACTOR_LAYER, TDTractorLayerClass))
+
+typedef struct _TDTractorLayer         TDTractorLayer;
+typedef struct _TDTractorLayerClass    TDTractorLayerClass;
+typedef struct _TDTractorLayerPrivate  TDTractorLayerPrivate;
+
+struct _TDTractorLayer
+{
+  /*< private >*/
+  ClutterActor parent_instance;
+
+  /*< private >*/
+  TDTractorLayerPrivate *priv;
+};
+
+struct _TDTractorLayerClass
+{
+  /*< private >*/
+  ClutterActorClass parent_class;
+};
+
+GType td_tractor_layer_get_type (void) G_GNUC_CONST;
+
+ClutterActor *td_tractor_layer_new (TDModel *model, int tractor_size);
+
+void td_tractor_layer_set_tractors (TDTractorLayer *layer,
+				    const TDSimTractors *tractors);
+
+void td_tractor_layer_set_lod_model (TDTractorLayer *layer,
+				     int level,
+				     TDModel *model);
+
+guint td_tractor_layer_get_n_draw_calls (TDTractorLayer *layer);
+void td_tractor_layer_get_n_culled (TDTractorLayer *layer,
+				    guint *n_culled,
+				    guint *n_lod);
+void td_tractor_layer_get_stats (TDTractorLayer *layer,
+				 guint *n_paints,
+				 guint64 *n_draw_calls,
+				 guint64 *n_culled,
+				 guint64 *n_lod,
+				 guint *max_tractors);
+
+G_END_DECLS
+
+#endif /* _HAVE_TD_TRACTOR_LAYER_H */
@@ -27,112 +27,332 @@
 #include <clutter-md2/clutter-md2.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <stdlib.h>
+#include <time.h>
+/* Cogl pulls in the GL or GLES header that Clutter was built with for
+   glFinish */
+#include <cogl/cogl.h>
 
 #include "tdnumber.h"
 #include "tdcornerlayout.h"
-
-#define LINE_WIDTH         15
-#define LINE_HEIGHT        30
-#define LINE_GAP           20
-
-#define CAR_MAX_ANGLE      25
-
-#define TRACTOR_RATE_MIN   1
-#define TRACTOR_RATE_START 10
-
-typedef struct _LineCallbackData LineCallbackData;
-
-struct _LineCallbackData
-{
-  int y_offset, road_start, road_end;
-  ClutterActor *line;
-};
+#include "tdsim.h"
+#include "tdtractorlayer.h"
+#include "tdmodel.h"
+#include "tdmodelcache.h"
+#include "tdroad.h"
+#include "tdscreenshot.h"
+#include "tdrecorder.h"
+#include "tdinputlog.h"
+#include "tdscenario.h"
+#include "tdstress.h"
+#include "tdbenchhistory.h"
+#include "tdprofiler.h"
+#include "tdmd2file.h"
+#include "tdhitboxes.h"
+
+/* Frame time in milliseconds that stress mode tries to stay within
+   unless STRESS_BUDGET gives another one */
+#define STRESS_DEFAULT_BUDGET 16.0f
+/* Tractors on the road at the first step of stress mode */
+#define STRESS_START_TRACTORS 50
+
+/* The profiler overlay shows the averages over this many
+   microseconds and is updated every PROFILER_UPDATE_TIME ms */
+#define PROFILER_WINDOW      G_USEC_PER_SEC
+#define PROFILER_UPDATE_TIME 500
+
+/* Key used to attach the hit boxes to a ClutterMD2Data */
+#define HIT_BOXES_KEY      "td-hit-boxes"
 
 typedef struct _GameData GameData;
+typedef struct _ModelLoad ModelLoad;
 
 struct _GameData
 {
-  ClutterEffectTemplate *eft;
-  ClutterActor *group;
-  ClutterMD2Data *tractor_data;
-  int tractor_size, road_width, road_left;
-  int road_start, road_end;
-  int add_rate;
+  TDSim *sim;
+  ClutterTimeline *game_tl;
+
+  /* Number of frames for averaging the collision pairs tested in
+     SHOW_STATS */
+  guint n_frames;
+
+  ClutterActor *group, *road;
+  TDModel *tractor_model;
+  ClutterActor *tractors;
 
   ClutterActor *car;
-  float angle;
-  int rotate_direction;
-  float position;
-  int stage_width;
+  /* ClutterMD2 draws the car so the time is taken around its paint
+     signal */
+  TDProfilerScope car_paint_scope;
 
   ClutterActor *number;
-  int score;
-};
 
-#define ROTATE_SPEED     80 /* Degrees per second */
-#define STRAIGHTEN_SPEED 20
+  ClutterActor *stage;
+  TDRecorder *recorder;
+
+  /* Steering is written to input_record as it happens or read back
+     from input_replay instead of the keyboard */
+  TDInputLog *input_record, *input_replay;
+
+  /* Time since main was entered and when the last startup phase
+     finished, for logging how long each phase takes */
+  GTimer *startup_timer;
+  gdouble last_phase_time;
+  gboolean assets_cached;
+  gulong first_paint_handler;
+  /* Wall time from starting the first model load to the last one
+     finishing and the time from starting to the first frame, in
+     seconds */
+  gdouble asset_load_time, first_frame_time;
+
+  /* frame_timer runs from the start of a new frame until the stage
+     has painted it. The times are summed for the benchmark history.
+     In stress mode the GPU is also waited on so that the time
+     includes rendering and not just submitting the commands */
+  GTimer *frame_timer;
+  gboolean frame_pending;
+  gdouble frame_time_sum;
+  guint n_timed_frames;
+
+  /* Raises the number of tractors until the frame time goes over
+     budget when STRESS names a file for the report */
+  TDStress *stress;
+  const char *stress_report;
+
+  /* Text showing the average time of each phase of a frame which is
+     toggled with P */
+  ClutterActor *profiler_overlay;
+  guint profiler_update_source;
+};
 
-#define FULL_MOVE_SPEED  0.5 /* stage widths per second */
+/* A model being loaded on a worker thread while the stage is set up */
+struct _ModelLoad
+{
+  const char *cache_filename;
+  const char *filename;
+  const char * const *extra_skins;
+  /* Colour variants of the first skin to generate after loading */
+  int n_skin_variants;
+  const TDSkinRemap *skin_variants;
+  /* The game can run without the model so it not being there isn't
+     an error */
+  gboolean optional;
+
+  GThread *thread;
+  /* The loads are timed against this so that their times can be
+     compared with each other */
+  GTimer *clock;
+
+  TDModel *model;
+  gboolean from_cache;
+  gdouble end_time, load_time;
+};
 
 static void
-on_car_rotate_frame (ClutterTimeline *tl, int frame_num, GameData *data)
+on_game_frame (ClutterTimeline *tl, int frame_num, GameData *data)
 {
   guint delta = clutter_timeline_get_delta (tl, NULL);
   guint speed = clutter_timeline_get_speed (tl);
+  ClutterActor *car = data->car;
+  TDProfilerScope scope;
+
+  td_profiler_begin (&scope, TD_PROFILER_PHASE_NEW_FRAME);
+
+  g_timer_start (data->frame_timer);
+  data->frame_pending = TRUE;
 
-  if (data->rotate_direction < 0)
+  td_sim_advance (data->sim, delta * 1000.0f / speed);
+
+  data->n_frames++;
+
+  /* Update the actors to match the new state of the simulation */
+  td_road_set_progress (TD_ROAD (data->road),
+			td_sim_get_road_progress (data->sim));
+
+  clutter_actor_set_rotation (car, CLUTTER_Z_AXIS,
+			      td_sim_get_car_angle (data->sim),
+			      clutter_actor_get_width (car) / 2,
+			      clutter_actor_get_height (car) / 2,
+			      0);
+  clutter_actor_set_x (car,
+		       td_sim_get_car_position (data->sim)
+		       - clutter_actor_get_width (car) / 2);
+
+  td_tractor_layer_set_tractors (TD_TRACTOR_LAYER (data->tractors),
+				 td_sim_get_tractors (data->sim));
+
+  td_number_set_value (TD_NUMBER (data->number),
+		       td_sim_get_score (data->sim));
+
+  if (td_sim_is_crashed (data->sim))
     {
-      data->angle -= delta * ROTATE_SPEED / (float) speed;
+      /* Game over so freeze everything */
+      clutter_timeline_stop (data->game_tl);
 
-      if (data->angle < -CAR_MAX_ANGLE)
-	data->angle = -CAR_MAX_ANGLE;
+      g_print ("Crashed! Final score: %i after %u ticks\n",
+	       td_sim_get_score (data->sim),
+	       td_sim_get_n_ticks (data->sim));
     }
-  else if (data->rotate_direction == 0)
+
+  td_profiler_end (&scope);
+}
+
+static void
+on_frame_painted (ClutterActor *stage, GameData *data)
+{
+  float msecs;
+
+  if (!data->frame_pending)
+    return;
+
+  data->frame_pending = FALSE;
+
+  /* GL commands are only queued during the paint so without this a
+     GPU-bound frame would look cheap. It stalls the pipeline so it is
+     only done when the frame times decide the tractor count */
+  if (data->stress)
+    glFinish ();
+
+  msecs = g_timer_elapsed (data->frame_timer, NULL) * 1000.0;
+
+  data->frame_time_sum += msecs;
+  data->n_timed_frames++;
+
+  if (data->stress == NULL
+      || !td_stress_add_frame (data->stress, msecs,
+			       td_sim_get_tractors (data->sim)->n_tractors))
+    return;
+
+  if (td_stress_is_finished (data->stress))
     {
-      float diff = delta * STRAIGHTEN_SPEED / (float) speed;
+      GError *error = NULL;
 
-      if (data->angle < 0)
-	{
-	  data->angle += diff;
-	  if (data->angle > 0)
-	    data->angle = 0;
-	}
-      else if (data->angle > 0)
+      g_print ("stress: at most %u tractors within budget\n",
+	       td_stress_get_max_sustainable (data->stress));
+
+      if (!td_stress_write_report (data->stress, data->stress_report,
+				   &error))
 	{
-	  data->angle -= diff;
-	  if (data->angle < 0)
-	    data->angle = 0;
+	  g_critical ("%s", error->message);
+	  g_error_free (error);
 	}
+
+      clutter_main_quit ();
     }
   else
-    {
-      data->angle += delta * ROTATE_SPEED / (float) speed;
+    td_sim_set_target_tractors (data->sim,
+				td_stress_get_target (data->stress));
+}
 
-      if (data->angle > CAR_MAX_ANGLE)
-	data->angle = CAR_MAX_ANGLE;
-    }
+static void
+on_record_frame (ClutterTimeline *tl, int frame_num, GameData *data)
+{
+  TDProfilerScope scope;
 
-  clutter_actor_set_rotation (data->car, CLUTTER_Z_AXIS, data->angle,
-			      clutter_actor_get_width (data->car) / 2,
-			      clutter_actor_get_height (data->car) / 2,
-			      0);
+  td_profiler_begin (&scope, TD_PROFILER_PHASE_CAPTURE);
+
+  /* Grab the stage as it was last drawn */
+  td_recorder_add_frame (data->recorder,
+			 clutter_stage_read_pixels
+			 (CLUTTER_STAGE (data->stage), 0, 0,
+			  td_recorder_get_width (data->recorder),
+			  td_recorder_get_height (data->recorder)));
+
+  td_profiler_end (&scope);
+}
+
+static gboolean
+update_profiler_overlay (GameData *data)
+{
+  double msecs_per_call[TD_PROFILER_N_PHASES];
+  double calls_per_sec[TD_PROFILER_N_PHASES];
+  GString *text = g_string_new ("phase           ms/call  calls/s");
+  int i;
+
+  td_profiler_get_averages (PROFILER_WINDOW, msecs_per_call, calls_per_sec);
+
+  for (i = 0; i < TD_PROFILER_N_PHASES; i++)
+    g_string_append_printf (text, "\n%-15s %7.3f %8.1f",
+			    td_profiler_get_phase_name (i),
+			    msecs_per_call[i], calls_per_sec[i]);
+
+  clutter_label_set_text (CLUTTER_LABEL (data->profiler_overlay), text->str);
+
+  g_string_free (text, TRUE);
+
+  return TRUE;
+}
+
+static void
+toggle_profiler_overlay (GameData *data)
+{
+  if (CLUTTER_ACTOR_IS_VISIBLE (data->profiler_overlay))
+    {
+      clutter_actor_hide (data->profiler_overlay);
+      g_source_remove (data->profiler_update_source);
+    }
+  else
+    {
+      update_profiler_overlay (data);
+      clutter_actor_show (data->profiler_overlay);
+      data->profiler_update_source
+	= g_timeout_add (PROFILER_UPDATE_TIME,
+			 (GSourceFunc) update_profiler_overlay, data);
+    }
+}
 
-  if (data->angle != 0)
+/* Writes the last few seconds of profiled phases to a file named
+   after the current time that can be loaded into chrome://tracing */
+static void
+dump_profiler_trace (void)
+{
+  GError *error = NULL;
+  char stamp[32], *filename;
+  GTimeVal now;
+  time_t secs;
+  struct tm tm;
+
+  /* The milliseconds keep traces dumped within a second apart */
+  g_get_current_time (&now);
+  secs = now.tv_sec;
+  localtime_r (&secs, &tm);
+  strftime (stamp, sizeof (stamp), "%Y%m%d-%H%M%S", &tm);
+  filename = g_strdup_printf ("trace-%s-%03li.json",
+			      stamp, now.tv_usec / 1000);
+
+  if (td_profiler_write_trace (filename, &error))
+    g_print ("wrote %s\n", filename);
+  else
     {
-      float slide_speed = data->angle * (float) FULL_MOVE_SPEED / CAR_MAX_ANGLE;
-      float offset = delta * slide_speed / speed * data->stage_width;
-
-      data->position += offset;
-
-      if (data->position < 0.0f)
-	data->position = 0.0f;
-      else if (data->position > data->stage_width)
-	data->position = data->stage_width;
-      
-      clutter_actor_set_x (data->car,
-			   data->position
-			   - clutter_actor_get_width (data->car) / 2);
+      g_critical ("%s", error->message);
+      g_error_free (error);
     }
+
+  g_free (filename);
+}
+
+/* Steering from the keyboard takes effect on the next tick so that
+   is the tick it is recorded against */
+static void
+steer (GameData *data, int direction)
+{
+  if (data->input_replay)
+    return;
+
+  td_sim_set_steer (data->sim, direction);
+
+  if (data->input_record)
+    td_input_log_add_steer (data->input_record,
+			    td_sim_get_n_ticks (data->sim),
+			    direction);
+}
+
+static void
+on_sim_tick (TDSim *sim, guint tick, GameData *data)
+{
+  int direction;
+
+  if (td_input_log_get_steer (data->input_replay, tick, &direction))
+    td_sim_set_steer (sim, direction);
 }
 
 static void
@@ -141,33 +361,34 @@ on_key_press (ClutterActor *stage, ClutterKeyEvent *event, GameData *data)
   switch (event->keyval)
     {
     case CLUTTER_Left:
-      data->rotate_direction = -1;
+      steer (data, -1);
       break;
 
     case CLUTTER_Right:
-      data->rotate_direction = 1;
+      steer (data, 1);
+      break;
+
+    case CLUTTER_p:
+      toggle_profiler_overlay (data);
+      break;
+
+    case CLUTTER_t:
+      dump_profiler_trace ();
       break;
 
     case CLUTTER_s:
       {
 	int width = clutter_actor_get_width (stage);
 	int height = clutter_actor_get_height (stage);
+	GTimer *timer = g_timer_new ();
 	guchar *data = clutter_stage_read_pixels (CLUTTER_STAGE (stage),
 						  0, 0, width, height);
-	guchar *p;
-	GdkPixbuf *pb;
 
-	for (p = data + width * height * 4; p > data; p -= 3)
-	  *(--p) = 0xff;
+	/* The conversion and encoding happen on another thread */
+	td_screenshot_save (data, width, height,
+			    g_timer_elapsed (timer, NULL));
 
-	pb = gdk_pixbuf_new_from_data (data, GDK_COLORSPACE_RGB, TRUE,
-				       8, width, height, width * 4,
-				       (GdkPixbufDestroyNotify) g_free,
-				       NULL);
-
-	gdk_pixbuf_save (pb, "screenie.png", "png", NULL, NULL);
-
-	g_object_unref (pb);
+	g_timer_destroy (timer);
       }
     }
 }
@@ -179,81 +400,211 @@ on_key_release (ClutterActor *stage, ClutterKeyEvent *event, GameData *data)
     {
     case CLUTTER_Left:
     case CLUTTER_Right:
-      data->rotate_direction = 0;
+      steer (data, 0);
       break;
     }
 }
 
+/* Maps the baked asset cache for a model if it is up to date and
+   otherwise falls back to loading the MD2 file and its skins. If the
+   model is optional a missing file is silently skipped and other
+   failures are only warnings */
+static TDModel *
+load_model (const char *cache_filename,
+	    const char *filename,
+	    const char * const *extra_skins,
+	    gboolean optional,
+	    gboolean *from_cache)
+{
+  TDModel *model;
+  GError *error = NULL;
+  int i;
+
+  if (!getenv ("NO_ASSET_CACHE"))
+    {
+      if ((model = td_model_cache_load (cache_filename, filename,
+					extra_skins, &error)))
+	{
+	  *from_cache = TRUE;
+	  return model;
+	}
+
+      /* A missing cache just means the assets haven't been baked */
+      if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+	g_warning ("%s", error->message);
+      g_clear_error (&error);
+    }
+
+  *from_cache = FALSE;
+
+  if ((model = td_model_load (filename, &error)) == NULL)
+    {
+      if (!optional)
+	g_critical ("%s: %s\n", filename, error->message);
+      else if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+	g_warning ("%s: %s\n", filename, error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  for (i = 0; extra_skins && extra_skins[i]; i++)
+    if (!td_model_add_skin (model, extra_skins[i], &error))
+      {
+	g_critical ("%s: %s\n", extra_skins[i], error->message);
+	g_clear_error (&error);
+      }
+
+  return model;
+}
+
+static gpointer
+model_load_thread (gpointer user_data)
+{
+  ModelLoad *load = user_data;
+  gdouble start_time = g_timer_elapsed (load->clock, NULL);
+  int i;
+
+  load->model = load_model (load->cache_filename,
+			    load->filename,
+			    load->extra_skins,
+			    load->optional,
+			    &load->from_cache);
+
+  if (load->model)
+    for (i = 0; i < load->n_skin_variants; i++)
+      td_model_add_skin_variant (load->model, 0, load->skin_variants + i);
+
+  load->end_time = g_timer_elapsed (load->clock, NULL);
+  load->load_time = load->end_time - start_time;
+
+  return load;
+}
+
 static void
-destroy_line_callback_data (gpointer data, GClosure *closure)
+model_load_start (ModelLoad *load, GTimer *clock)
 {
-  g_slice_free (LineCallbackData, data);
+  GError *error = NULL;
+
+  load->clock = clock;
+
+  load->thread = g_thread_create (model_load_thread, load, TRUE, &error);
+
+  if (load->thread == NULL)
+    {
+      /* Just load it when it is needed instead */
+      g_warning ("%s", error->message);
+      g_error_free (error);
+    }
 }
 
+static TDModel *
+model_load_finish (ModelLoad *load)
+{
+  if (load->thread)
+    g_thread_join (load->thread);
+  else
+    model_load_thread (load);
+
+  g_print ("startup:   %s: %.1f ms%s\n", load->filename,
+	   load->load_time * 1000.0,
+	   load->from_cache ? " (cached)" : "");
+
+  return load->model;
+}
+
+/* Adds a finished load to the startup stats. The loads overlap so
+   the time is taken up to whichever one finished last rather than
+   summed */
 static void
-on_new_frame_for_line (ClutterTimeline *tl,
-		       gint frame_num,
-		       LineCallbackData *data)
+model_load_account (const ModelLoad *load, GameData *data,
+		    gdouble start_time)
 {
-  int num_frames = clutter_timeline_get_n_frames (tl);
-
-  clutter_actor_set_y (data->line,
-		       (data->y_offset
-			- data->road_start
-			+ (frame_num * (data->road_end - data->road_start)
-			   / num_frames))
-		       % (data->road_end - data->road_start)
-		       - LINE_HEIGHT - LINE_GAP + data->road_start);
+  if (load->end_time - start_time > data->asset_load_time)
+    data->asset_load_time = load->end_time - start_time;
+
+  if (load->model && !load->from_cache)
+    data->assets_cached = FALSE;
 }
 
-static ClutterTimeline *
-make_line_animation (ClutterActor *group, int stage_width,
-		     int road_start, int road_end)
+/* Returns the time since main was entered */
+static gdouble
+log_startup_phase (GameData *data, const char *phase)
 {
-  int ypos = road_start;
-  ClutterTimeline *tl;
-  static const ClutterColor line_color = { 0xe0, 0xe0, 0x00, 0xff };
+  gdouble now = g_timer_elapsed (data->startup_timer, NULL);
+
+  g_print ("startup: %s: %.1f ms (%.1f ms total)\n", phase,
+	   (now - data->last_phase_time) * 1000.0, now * 1000.0);
 
-  tl = clutter_timeline_new_for_duration (4000);
+  data->last_phase_time = now;
 
-  /* Extend the road to be a multiple of the distance between lines */
-  road_end += ((LINE_HEIGHT + LINE_GAP - 1)
-	       - (road_end - road_start) % (LINE_HEIGHT + LINE_GAP))
-    + LINE_HEIGHT + LINE_GAP;
+  return now;
+}
+
+static void
+on_first_paint (ClutterActor *stage, GameData *data)
+{
+  g_signal_handler_disconnect (stage, data->first_paint_handler);
+
+  data->first_frame_time
+    = log_startup_phase (data, data->assets_cached
+			 ? "first frame (asset cache used)"
+			 : "first frame (asset cache not used)");
+}
+
+/* Adds how long the game took to start and draw its frames to the
+   benchmark history if BENCH_HISTORY names one. Loading without the
+   asset cache is much slower so it is kept as a separate metric */
+static void
+record_history (GameData *data)
+{
+  TDBenchHistory *history = td_bench_history_open_from_env ();
+  const char *suffix = data->assets_cached ? "" : "_uncached";
+  double value;
+  char *metric;
+
+  if (history == NULL)
+    return;
+
+  value = data->asset_load_time * 1000.0;
+  metric = g_strconcat ("game.asset_load", suffix, "_ms", NULL);
+  td_bench_history_add (history, metric, TD_BENCH_LOWER_IS_BETTER,
+			&value, 1);
+  g_free (metric);
+
+  if (data->first_frame_time > 0.0)
+    {
+      value = data->first_frame_time * 1000.0;
+      metric = g_strconcat ("game.startup", suffix, "_ms", NULL);
+      td_bench_history_add (history, metric, TD_BENCH_LOWER_IS_BETTER,
+			    &value, 1);
+      g_free (metric);
+    }
 
-  while (ypos < road_end)
+  if (data->n_timed_frames > 0)
     {
-      ClutterActor *line = clutter_rectangle_new_with_color (&line_color);
-      LineCallbackData *data;
-      
-      clutter_actor_set_position (line, stage_width / 2 - LINE_WIDTH / 2,
-				  ypos - LINE_HEIGHT - LINE_GAP);
-      clutter_actor_set_size (line, LINE_WIDTH, LINE_HEIGHT);
-      
-      clutter_container_add (CLUTTER_CONTAINER (group), line, NULL);
-
-      data = g_slice_new (LineCallbackData);
-      data->y_offset = ypos;
-      data->road_start = road_start;
-      data->road_end = road_end;
-      data->line = line;
-
-      g_signal_connect_data (tl, "new-frame",
-			     G_CALLBACK (on_new_frame_for_line),
-			     data,
-			     destroy_line_callback_data,
-			     0);
-
-      ypos += LINE_HEIGHT + LINE_GAP;
+      value = data->frame_time_sum / data->n_timed_frames;
+      td_bench_history_add (history, "game.frame_ms",
+			    TD_BENCH_LOWER_IS_BETTER, &value, 1);
     }
 
-  return tl;
+  if (data->stress)
+    {
+      value = td_stress_get_max_sustainable (data->stress);
+      td_bench_history_add (history, "game.stress_max_tractors",
+			    TD_BENCH_HIGHER_IS_BETTER, &value, 1);
+    }
+
+  td_bench_history_save_and_free (history);
 }
 
+/* The car is drawn by ClutterMD2 which needs the GL context to load
+   its skins so this can't be done on a thread or come from the asset
+   cache */
 static ClutterMD2Data *
 get_data (const char *filename)
 {
   ClutterMD2Data *data = clutter_md2_data_new ();
+  TDMD2File *file;
   GError *error = NULL;
 
   g_object_ref_sink (data);
@@ -264,62 +615,34 @@ get_data (const char *filename)
       g_error_free (error);
     }
 
-  return data;
-}
-
-static void
-add_skin (ClutterMD2Data *data, const char *filename)
-{
-  GError *error = NULL;
-
-  if (!clutter_md2_data_add_skin (data, filename, &error))
+  /* Keep a box around each keyframe along with the data so that the
+     collision detection doesn't need to look at the vertices */
+  if ((file = td_md2_file_load (filename, &error)) == NULL)
     {
       g_critical ("%s: %s\n", filename, error->message);
       g_error_free (error);
     }
+  else
+    {
+      g_object_set_data_full (G_OBJECT (data), HIT_BOXES_KEY,
+			      td_hit_boxes_new (file),
+			      (GDestroyNotify) td_hit_boxes_free);
+      td_md2_file_free (file);
+    }
+
+  return data;
 }
 
-static gboolean
-add_tractor (gpointer user_data)
+static void
+on_car_paint (ClutterActor *car, GameData *data)
 {
-  GameData *data = (GameData *) user_data;
-  ClutterActor *tractor;
-  int xpos;
-  int num_skins;
-
-  tractor = clutter_md2_new ();
-  clutter_md2_set_data (CLUTTER_MD2 (tractor), data->tractor_data);
-  clutter_actor_set_rotation (tractor, CLUTTER_Z_AXIS, 180.0,
-			      data->tractor_size / 2,
-			      data->tractor_size / 2,
-			      0);
-
-  clutter_actor_set_size (tractor, data->tractor_size, data->tractor_size);
-
-  xpos = rand () % data->road_width + data->road_left;
-  clutter_actor_set_position (tractor, xpos, data->road_start
-			      - data->tractor_size);
-  clutter_container_add (CLUTTER_CONTAINER (data->group), tractor, NULL);
-
-  num_skins = clutter_md2_get_n_skins (CLUTTER_MD2 (tractor));
-  clutter_md2_set_current_skin (CLUTTER_MD2 (tractor),
-				rand () % num_skins);
-
-  clutter_effect_move (data->eft, tractor, xpos, data->road_end,
-		       (ClutterEffectCompleteFunc) clutter_actor_destroy,
-		       tractor);
-
-  /* Start another tractor some time later */
-  g_timeout_add_seconds (rand () % (data->add_rate - TRACTOR_RATE_MIN + 1)
-			 + TRACTOR_RATE_MIN, add_tractor, user_data);
-  /* Increase the rate for the next tractor */
-  if (data->add_rate > TRACTOR_RATE_MIN)
-    data->add_rate--;
-
-  /* Increase the player's score */
-  td_number_set_value (TD_NUMBER (data->number), ++data->score);
+  td_profiler_begin (&data->car_paint_scope, TD_PROFILER_PHASE_PAINT_CAR);
+}
 
-  return FALSE;
+static void
+on_car_paint_after (ClutterActor *car, GameData *data)
+{
+  td_profiler_end (&data->car_paint_scope);
 }
 
 int
@@ -327,15 +650,73 @@ main (int argc, char **argv)
 {
   ClutterActor *stage, *group, *road, *car, *number_layout;
   static const ClutterColor grass_color = { 0x10, 0xa0, 0x00, 0xff };
-  static const ClutterColor road_color = { 0x60, 0x60, 0x60, 0xff };
+  static const ClutterColor profiler_color = { 0xff, 0xff, 0xff, 0xff };
   int stage_width, stage_height;
-  ClutterTimeline *line_tl, *car_rotate_tl;
-  ClutterMD2Data *car_md2_data;
-  int car_size, road_length;
+  ClutterTimeline *game_tl;
+  ClutterMD2Data *car_data;
+  TDScenario *scenario = NULL;
+  /* The red tractor is the green one with its paint moved round the
+     colour wheel */
+  static const TDSkinRemapEntry red_entries[] = { { 130, 50, 350 } };
+  static const TDSkinRemap tractor_variants[] =
+    { { "red", 40, G_N_ELEMENTS (red_entries), red_entries } };
+  ModelLoad tractor_load =
+    { "data/tractor/tractor.tdm", "data/tractor/tractor.md2", NULL,
+      G_N_ELEMENTS (tractor_variants), tractor_variants };
+  /* Simpler tractors for the distance made by tddecimate. Without
+     them the far tractors are drawn with the full model */
+  ModelLoad tractor_lod_loads[TD_TRACTOR_LAYER_N_LEVELS - 1] =
+    {
+      { "data/tractor/tractor_lod1.tdm", "data/tractor/tractor_lod1.md2",
+	NULL, 0, NULL, TRUE },
+      { "data/tractor/tractor_lod2.tdm", "data/tractor/tractor_lod2.md2",
+	NULL, 0, NULL, TRUE }
+    };
+  int car_size, road_length, tractor_size, i;
   GameData game_data;
+  TDSimConfig sim_config;
+  gdouble asset_load_start;
+  static const TDSimCallbacks replay_callbacks =
+    { NULL, NULL, (void (*) (TDSim *, guint, gpointer)) on_sim_tick };
+
+  /* Screenshots are saved from a separate thread. This has to come
+     before any other GLib call */
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+
+  game_data.startup_timer = g_timer_new ();
+  game_data.last_phase_time = 0.0;
+
+  /* The models don't need GL so they can be parsed and their skins
+     decoded while Clutter is starting up. The image loaders are
+     registered up front so the threads don't race to do it */
+  g_type_init ();
+  g_slist_free (gdk_pixbuf_get_formats ());
+  asset_load_start = g_timer_elapsed (game_data.startup_timer, NULL);
+  model_load_start (&tractor_load, game_data.startup_timer);
+  for (i = 0; i < G_N_ELEMENTS (tractor_lod_loads); i++)
+    model_load_start (tractor_lod_loads + i, game_data.startup_timer);
 
   clutter_init (&argc, &argv);
 
+  log_startup_phase (&game_data, "clutter_init");
+
+  game_data.tractor_model = model_load_finish (&tractor_load);
+  for (i = 0; i < G_N_ELEMENTS (tractor_lod_loads); i++)
+    model_load_finish (tractor_lod_loads + i);
+
+  log_startup_phase (&game_data, "asset loads");
+
+  if (game_data.tractor_model == NULL)
+    return 1;
+  game_data.assets_cached = TRUE;
+  game_data.asset_load_time = 0.0;
+  model_load_account (&tractor_load, &game_data, asset_load_start);
+  for (i = 0; i < G_N_ELEMENTS (tractor_lod_loads); i++)
+    model_load_account (tractor_lod_loads + i, &game_data,
+			asset_load_start);
+  game_data.first_frame_time = 0.0;
+
   stage = clutter_stage_get_default ();
 
   if (getenv ("FULLSCREEN"))
@@ -351,84 +732,264 @@ main (int argc, char **argv)
 
   clutter_stage_set_color (CLUTTER_STAGE (stage), &grass_color);
 
-  road = clutter_rectangle_new_with_color (&road_color);
+  road = td_road_new ();
   clutter_actor_set_position (road, stage_width / 8,
 			      stage_height - road_length);
   clutter_actor_set_size (road, stage_width * 3 / 4, road_length);
   
   clutter_container_add (CLUTTER_CONTAINER (group), road, NULL);
+  game_data.road = road;
 
-  line_tl = make_line_animation (group, stage_width, stage_height - road_length,
-				 stage_height);
-
-  clutter_timeline_set_loop (line_tl, TRUE);
-  clutter_timeline_start (line_tl);
-
-  game_data.tractor_data = get_data ("data/tractor/tractor.md2");
-  add_skin (game_data.tractor_data, "data/tractor/tractor_red.png");
+  tractor_size = stage_width * 3 / 16;
+  game_data.group = group;
+  /* All of the tractors are drawn by one actor in the group's
+     coordinates */
+  game_data.tractors = td_tractor_layer_new (game_data.tractor_model,
+					     tractor_size);
+  clutter_actor_set_size (game_data.tractors, stage_width, stage_height);
+  /* The levels of detail aren't essential so the full tractor is used
+     in place of any that failed to load */
+  for (i = 0; i < G_N_ELEMENTS (tractor_lod_loads); i++)
+    if (tractor_lod_loads[i].model)
+      {
+	td_tractor_layer_set_lod_model (TD_TRACTOR_LAYER (game_data.tractors),
+					i + 1, tractor_lod_loads[i].model);
+	td_model_unref (tractor_lod_loads[i].model);
+      }
+  clutter_container_add (CLUTTER_CONTAINER (group), game_data.tractors, NULL);
 
-  game_data.eft
-    = clutter_effect_template_new_for_duration (10000, CLUTTER_ALPHA_SINE_INC);
+  car_data = get_data ("data/car/car.md2");
+  if (g_object_get_data (G_OBJECT (car_data), HIT_BOXES_KEY) == NULL)
+    return 1;
 
-  game_data.tractor_size = stage_width * 3 / 16;
-  game_data.road_width = clutter_actor_get_width (road);
-  game_data.road_left = clutter_actor_get_x (road);
-  game_data.road_start = stage_height - road_length;
-  game_data.road_end = stage_height;
-  game_data.group = group;
-  game_data.add_rate = TRACTOR_RATE_START;
+  log_startup_phase (&game_data, "data/car/car.md2");
 
-  car_md2_data = get_data ("data/car/car.md2");
   car = clutter_md2_new ();
-  clutter_md2_set_data (CLUTTER_MD2 (car), car_md2_data);
-  g_object_unref (car_md2_data);
+  clutter_md2_set_data (CLUTTER_MD2 (car), car_data);
+  g_signal_connect (car, "paint", G_CALLBACK (on_car_paint), &game_data);
+  g_signal_connect_after (car, "paint", G_CALLBACK (on_car_paint_after),
+			  &game_data);
 
-  car_size = game_data.tractor_size * 3 / 4;
+  car_size = tractor_size * 3 / 4;
   clutter_actor_set_position (car, stage_width / 2 - car_size / 2,
 			      stage_height - car_size * 4 / 3);
   clutter_actor_set_size (car, car_size, car_size);
   clutter_container_add (CLUTTER_CONTAINER (group), car, NULL);
 
   game_data.car = car;
-  game_data.angle = 0;
-  game_data.rotate_direction = 0;
-  game_data.position = stage_width / 2.0f;
-  game_data.stage_width = stage_width;
 
   number_layout = td_corner_layout_new ();
   clutter_actor_set_size (number_layout, stage_width, stage_height);
 
   game_data.number = td_number_new ();
-  td_number_set_value (TD_NUMBER (game_data.number), game_data.score = 0);
+  td_number_set_value (TD_NUMBER (game_data.number), 0);
 
   clutter_container_add (CLUTTER_CONTAINER (number_layout),
 			 game_data.number, NULL);
 
   clutter_container_add (CLUTTER_CONTAINER (stage), number_layout, NULL);
 
-  add_tractor (&game_data);
+  /* Timing the phases of each frame is cheap enough to always do so
+     that a trace can be dumped whenever something looks slow */
+  td_profiler_set_enabled (TRUE);
+  game_data.profiler_overlay
+    = clutter_label_new_full ("Monospace 10", "", &profiler_color);
+  clutter_container_add (CLUTTER_CONTAINER (stage),
+			 game_data.profiler_overlay, NULL);
+  clutter_actor_hide (game_data.profiler_overlay);
+
+  sim_config.stage_width = stage_width;
+  sim_config.road_left = clutter_actor_get_x (road);
+  sim_config.road_width = clutter_actor_get_width (road);
+  sim_config.road_start = stage_height - road_length;
+  sim_config.road_end = stage_height;
+  sim_config.tractor_size = tractor_size;
+  sim_config.n_skins = game_data.tractor_model->n_skins;
+  sim_config.car_size = car_size;
+  sim_config.car_y = clutter_actor_get_y (car);
+  sim_config.tractor_boxes = game_data.tractor_model->hit_boxes;
+  sim_config.car_boxes = g_object_get_data (G_OBJECT (car_data),
+					    HIT_BOXES_KEY);
+  sim_config.scenario = NULL;
+
+  /* A scenario adds the tractors at fixed times instead of the usual
+     ramp so that the same scene can be played again */
+  if (getenv ("SCENARIO"))
+    {
+      GError *error = NULL;
+
+      if ((scenario = td_scenario_load (getenv ("SCENARIO"), &error)) == NULL)
+	{
+	  g_critical ("%s", error->message);
+	  g_error_free (error);
+	  return 1;
+	}
+
+      g_print ("scenario: %s\n", td_scenario_get_name (scenario));
+      sim_config.scenario = scenario;
+    }
+
+  /* A replay plays the game that was recorded with its seed and its
+     steering. It only matches if the stage is the same size too */
+  game_data.input_record = NULL;
+  game_data.input_replay = NULL;
+
+  if (getenv ("REPLAY_INPUT"))
+    {
+      GError *error = NULL;
+
+      game_data.input_replay = td_input_log_load (getenv ("REPLAY_INPUT"),
+						  &error);
+
+      if (game_data.input_replay == NULL)
+	{
+	  g_critical ("%s", error->message);
+	  g_error_free (error);
+	  return 1;
+	}
+
+      sim_config.seed = td_input_log_get_seed (game_data.input_replay);
+    }
+  else if (getenv ("SEED"))
+    sim_config.seed = strtoul (getenv ("SEED"), NULL, 10);
+  else
+    sim_config.seed = g_random_int ();
+
+  g_print ("seed: %u\n", sim_config.seed);
+
+  game_data.sim = td_sim_new (&sim_config);
+  if (scenario && td_scenario_get_invincible (scenario))
+    td_sim_set_invincible (game_data.sim, TRUE);
+
+  if (game_data.input_replay)
+    td_sim_set_callbacks (game_data.sim, &replay_callbacks, &game_data);
+  else if (getenv ("RECORD_INPUT"))
+    {
+      GError *error = NULL;
+
+      game_data.input_record = td_input_log_new (getenv ("RECORD_INPUT"),
+						 sim_config.seed,
+						 &error);
+
+      if (game_data.input_record == NULL)
+	{
+	  g_critical ("%s", error->message);
+	  g_error_free (error);
+	}
+    }
 
   g_signal_connect (stage, "key-press-event",
 		    G_CALLBACK (on_key_press), &game_data);
   g_signal_connect (stage, "key-release-event",
 		    G_CALLBACK (on_key_release), &game_data);
-  car_rotate_tl = clutter_timeline_new_for_duration (1000);
-  clutter_timeline_set_loop (car_rotate_tl, TRUE);
-  clutter_timeline_start (car_rotate_tl);
-  g_signal_connect (car_rotate_tl, "new-frame",
-		    G_CALLBACK (on_car_rotate_frame), &game_data);
+  game_data.n_frames = 0;
+
+  game_tl = clutter_timeline_new_for_duration (1000);
+  clutter_timeline_set_loop (game_tl, TRUE);
+  clutter_timeline_start (game_tl);
+  g_signal_connect (game_tl, "new-frame",
+		    G_CALLBACK (on_game_frame), &game_data);
+  game_data.game_tl = game_tl;
+
+  game_data.stage = stage;
+  game_data.recorder = NULL;
+
+  if (getenv ("RECORD"))
+    {
+      GError *error = NULL;
+
+      game_data.recorder = td_recorder_new (getenv ("RECORD"),
+					    stage_width, stage_height,
+					    clutter_get_default_frame_rate (),
+					    &error);
+
+      if (game_data.recorder)
+	g_signal_connect_after (game_tl, "new-frame",
+				G_CALLBACK (on_record_frame), &game_data);
+      else
+	{
+	  g_critical ("%s", error->message);
+	  g_error_free (error);
+	}
+    }
+
+  game_data.frame_timer = g_timer_new ();
+  game_data.frame_pending = FALSE;
+  game_data.frame_time_sum = 0.0;
+  game_data.n_timed_frames = 0;
+  g_signal_connect_after (stage, "paint",
+			  G_CALLBACK (on_frame_painted), &game_data);
+
+  /* The car can't crash in stress mode so the run only ends once the
+     frames get too slow */
+  game_data.stress = NULL;
+
+  if ((game_data.stress_report = getenv ("STRESS")))
+    {
+      float budget = STRESS_DEFAULT_BUDGET;
+
+      if (getenv ("STRESS_BUDGET"))
+	budget = g_ascii_strtod (getenv ("STRESS_BUDGET"), NULL);
+
+      game_data.stress = td_stress_new (STRESS_START_TRACTORS, budget);
+
+      td_sim_set_invincible (game_data.sim, TRUE);
+      td_sim_set_target_tractors (game_data.sim,
+				  td_stress_get_target (game_data.stress));
+    }
+
+  log_startup_phase (&game_data, "scene build");
+
+  game_data.first_paint_handler
+    = g_signal_connect_after (stage, "paint",
+			      G_CALLBACK (on_first_paint), &game_data);
 
   clutter_actor_show (stage);
 
   clutter_main ();
 
-  /* Remove all add tractor sources */
-  while (g_source_remove_by_user_data (&game_data));
+  if (getenv ("SHOW_STATS"))
+    {
+      guint n_paints, max_tractors;
+      guint64 n_draw_calls, n_culled, n_lod;
+
+      td_tractor_layer_get_stats (TD_TRACTOR_LAYER (game_data.tractors),
+				  &n_paints, &n_draw_calls, &n_culled, &n_lod,
+				  &max_tractors);
+      if (n_paints > 0)
+	g_print ("tractor draw calls: %.2f per frame, %u tractors at most\n"
+		 "tractors culled: %.2f per frame, far detail: %.2f "
+		 "per frame\n",
+		 n_draw_calls / (double) n_paints, max_tractors,
+		 n_culled / (double) n_paints, n_lod / (double) n_paints);
+
+      if (game_data.n_frames > 0)
+	g_print ("collision pairs tested: %.2f per frame\n",
+		 td_sim_get_total_candidates (game_data.sim)
+		 / (double) game_data.n_frames);
+    }
 
-  g_object_unref (car_rotate_tl);
-  g_object_unref (game_data.eft);
-  g_object_unref (game_data.tractor_data);
-  g_object_unref (line_tl);
+  record_history (&game_data);
+
+  td_screenshot_flush ();
+
+  if (game_data.recorder)
+    td_recorder_free (game_data.recorder);
+  if (game_data.input_record)
+    td_input_log_free (game_data.input_record);
+  if (game_data.input_replay)
+    td_input_log_free (game_data.input_replay);
+  if (game_data.stress)
+    td_stress_free (game_data.stress);
+
+  g_object_unref (game_tl);
+  td_sim_free (game_data.sim);
+  if (scenario)
+    td_scenario_free (scenario);
+  td_model_unref (game_data.tractor_model);
+  g_object_unref (car_data);
+  g_timer_destroy (game_data.startup_timer);
+  g_timer_destroy (game_data.frame_timer);
 
   return 0;
 }